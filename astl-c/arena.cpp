@@ -0,0 +1,82 @@
+/*
+   Copyright (C) 2026 The Astl-C contributors
+   ----------------------------------------------------------------------------
+   Astl-C is free software; you can redistribute it
+   and/or modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either version
+   2 of the License, or (at your option) any later version.
+
+   Astl-C is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+#include <cstdlib>
+#include <new>
+#include "arena.hpp"
+
+namespace AstlC {
+
+static constexpr std::size_t block_size = 256 * 1024;
+static constexpr std::size_t alignment = alignof(std::max_align_t);
+
+// constructor ===============================================================
+
+NodeArena::NodeArena() : next(nullptr), limit(nullptr), refcount(1) {
+}
+
+NodeArena::~NodeArena() {
+   for (auto block: blocks) {
+      std::free(block);
+   }
+}
+
+// mutators ==================================================================
+
+void* NodeArena::allocate(std::size_t size) {
+   size = (size + alignment - 1) & ~(alignment - 1);
+   if (size > block_size / 4) {
+      /* large allocations get a block of their own */
+      blocks.reserve(blocks.size() + 1);
+      char* block = static_cast<char*>(std::malloc(size));
+      if (!block) throw std::bad_alloc();
+      blocks.push_back(block);
+      ++refcount;
+      return block;
+   }
+   if (static_cast<std::size_t>(limit - next) < size) {
+      blocks.reserve(blocks.size() + 1);
+      char* block = static_cast<char*>(std::malloc(block_size));
+      if (!block) throw std::bad_alloc();
+      blocks.push_back(block);
+      next = block; limit = block + block_size;
+   }
+   void* p = next; next += size;
+   ++refcount;
+   return p;
+}
+
+/* individual allocations are not reused,
+   we just keep track of the number of live allocations */
+void NodeArena::deallocate() {
+   unref();
+}
+
+void NodeArena::release() {
+   unref();
+}
+
+// private mutators ==========================================================
+
+void NodeArena::unref() {
+   if (--refcount == 0) {
+      delete this;
+   }
+}
+
+} // namespace AstlC
@@ -0,0 +1,121 @@
+/*
+   Copyright (C) 2026 The Astl-C contributors
+   ----------------------------------------------------------------------------
+   Astl-C is free software; you can redistribute it
+   and/or modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either version
+   2 of the License, or (at your option) any later version.
+
+   Astl-C is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+#ifndef ASTL_C_ARENA_H
+#define ASTL_C_ARENA_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+#include <astl/syntax-tree.hpp>
+
+namespace AstlC {
+
+   /* memory for the nodes of one syntax tree which is carved
+      from large blocks; the blocks are released together as soon
+      as the owner has released the arena and all nodes
+      allocated from it are gone */
+   class NodeArena {
+      public:
+	 // constructor
+	 NodeArena();
+	 NodeArena(const NodeArena&) = delete;
+	 NodeArena& operator=(const NodeArena&) = delete;
+
+	 // mutators
+	 void* allocate(std::size_t size);
+	 void deallocate();
+	 void release(); // to be called once by the owner
+
+	 /* deleter for std::unique_ptr which releases the arena */
+	 struct Releaser {
+	    void operator()(NodeArena* arena) const {
+	       arena->release();
+	    }
+	 };
+
+      private:
+	 std::vector<char*> blocks;
+	 char* next; // next free byte within the current block
+	 char* limit; // end of the current block
+	 /* number of live allocations, +1 as long as it is owned */
+	 std::atomic<std::size_t> refcount;
+
+	 ~NodeArena();
+	 void unref();
+   };
+
+   typedef std::unique_ptr<NodeArena, NodeArena::Releaser> NodeArenaPtr;
+
+   /* allocator for std::allocate_shared which places the
+      node together with its control block into an arena */
+   template<typename T>
+   class NodeArenaAllocator {
+      public:
+	 typedef T value_type;
+
+	 NodeArenaAllocator(NodeArena* arena) : arena(arena) {
+	 }
+	 template<typename U>
+	 NodeArenaAllocator(const NodeArenaAllocator<U>& other) :
+	       arena(other.get_arena()) {
+	 }
+
+	 T* allocate(std::size_t n) {
+	    return static_cast<T*>(arena->allocate(n * sizeof(T)));
+	 }
+	 void deallocate(T*, std::size_t) {
+	    arena->deallocate();
+	 }
+	 NodeArena* get_arena() const {
+	    return arena;
+	 }
+
+      private:
+	 NodeArena* arena;
+   };
+
+   template<typename T, typename U>
+   inline bool operator==(const NodeArenaAllocator<T>& a1,
+	 const NodeArenaAllocator<U>& a2) {
+      return a1.get_arena() == a2.get_arena();
+   }
+   template<typename T, typename U>
+   inline bool operator!=(const NodeArenaAllocator<T>& a1,
+	 const NodeArenaAllocator<U>& a2) {
+      return a1.get_arena() != a2.get_arena();
+   }
+
+   /* create a node within the given arena or,
+      if there is none, on the heap */
+   template<typename... Args>
+   inline Astl::NodePtr make_node(NodeArena* arena, Args&&... args) {
+      if (arena) {
+	 return std::allocate_shared<Astl::Node>(
+	    NodeArenaAllocator<Astl::Node>(arena),
+	    std::forward<Args>(args)...);
+      } else {
+	 return std::make_shared<Astl::Node>(std::forward<Args>(args)...);
+      }
+   }
+
+} // namespace AstlC
+
+#endif
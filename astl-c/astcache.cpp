@@ -0,0 +1,359 @@
+/*
+   Copyright (C) 2026 The Astl-C contributors
+   ----------------------------------------------------------------------------
+   Astl-C is free software; you can redistribute it
+   and/or modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either version
+   2 of the License, or (at your option) any later version.
+
+   Astl-C is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+#include <astl/operator.hpp>
+#include <astl/token.hpp>
+#include <astl/treeloc.hpp>
+#include "astcache.hpp"
+#include "cache.hpp"
+#include "filenames.hpp"
+#include "hash.hpp"
+#include "yytname.hpp"
+
+using namespace Astl;
+
+namespace AstlC {
+
+/*
+   Format of a serialized syntax tree:
+
+      tree = operators filenames node
+      operators = count { string }
+      filenames = count { string }
+      node = flags [filename] begin-line begin-column
+	 [filename] end-line end-column
+	 ( tokenval string | operator count { node } )
+      string = length { byte }
+
+   All numbers are stored as variable-length unsigned integers
+   with 7 bits per byte, signed values are zigzag-encoded.
+   The flags tell whether the node is a leaf and whether the
+   filenames differ from those of the preceding node and from the
+   beginning of the location, respectively; the filename is stored
+   just in these cases as index into the filename table where
+   0 represents the null pointer. The beginning line is stored
+   relative to that of the preceding node in preorder and the
+   ending line relative to the beginning line.
+*/
+
+/* identifies the parser and the serialization which have built
+   a tree such that trees of other versions of astl-c are not taken:
+   the grammar symbols and the size and modification time of the
+   executable, if available */
+static std::string get_parser_identity() {
+   Hash hash;
+   for (const char* const* name = yytname; *name; ++name) {
+      hash.add(*name);
+   }
+   std::ostringstream os;
+   os << hash.get_hex();
+   struct stat statbuf;
+   if (stat("/proc/self/exe", &statbuf) == 0) {
+      os << " " << statbuf.st_size << " " << statbuf.st_mtim.tv_sec <<
+	 "." << statbuf.st_mtim.tv_nsec;
+   }
+   return os.str();
+}
+
+/* kind of cache entries of the given flavour */
+static std::string get_kind(const std::string& flavour) {
+   static const std::string parser_identity = get_parser_identity();
+   return flavour + " " + parser_identity;
+}
+
+static const unsigned int LEAF_FLAG = 1;
+static const unsigned int NULL_FLAG = 2;
+static const unsigned int BEGIN_FILENAME_FLAG = 4;
+static const unsigned int END_FILENAME_FLAG = 8;
+
+// private classes ===========================================================
+
+class Writer {
+   public:
+      Writer() : filename(nullptr), line(0) {
+      }
+
+      std::string get_data() {
+	 std::string data;
+	 std::swap(out, data);
+	 put(operators.size());
+	 for (auto& op: operators) {
+	    put(op);
+	 }
+	 put(filenames.size());
+	 for (auto& name: filenames) {
+	    put(*name);
+	 }
+	 out += data;
+	 return out;
+      }
+
+      void put_node(NodePtr node) {
+	 if (!node) {
+	    put(NULL_FLAG); return;
+	 }
+	 const Location& loc = node->get_location();
+	 unsigned int flags = 0;
+	 if (node->is_leaf()) flags |= LEAF_FLAG;
+	 if (loc.begin.filename != filename) flags |= BEGIN_FILENAME_FLAG;
+	 if (loc.end.filename != loc.begin.filename) flags |= END_FILENAME_FLAG;
+	 put(flags);
+	 if (flags & BEGIN_FILENAME_FLAG) {
+	    put_filename(loc.begin.filename);
+	    filename = loc.begin.filename;
+	 }
+	 put_signed(std::int64_t(loc.begin.line) - line);
+	 put(loc.begin.column);
+	 line = loc.begin.line;
+	 if (flags & END_FILENAME_FLAG) {
+	    put_filename(loc.end.filename);
+	 }
+	 put_signed(std::int64_t(loc.end.line) - loc.begin.line);
+	 put(loc.end.column);
+	 if (node->is_leaf()) {
+	    const Token& token = node->get_token();
+	    put_signed(token.get_tokenval());
+	    put(token.get_text());
+	 } else {
+	    put_operator(node->get_op());
+	    put(node->size());
+	    for (std::size_t i = 0; i < node->size(); ++i) {
+	       put_node(node->get_operand(i));
+	    }
+	 }
+      }
+
+   private:
+      std::string out;
+      std::vector<std::string> operators;
+      std::map<std::string, std::uint64_t> operator_index;
+      std::vector<const std::string*> filenames;
+      std::map<const std::string*, std::uint64_t> filename_index;
+      const std::string* filename; // of the preceding node
+      std::int64_t line; // of the preceding node
+
+      void put(std::uint64_t value) {
+	 while (value >= 0x80) {
+	    out += static_cast<char>((value & 0x7f) | 0x80);
+	    value >>= 7;
+	 }
+	 out += static_cast<char>(value);
+      }
+      void put_signed(std::int64_t value) {
+	 put((static_cast<std::uint64_t>(value) << 1) ^
+	    static_cast<std::uint64_t>(value >> 63));
+      }
+      void put(const std::string& s) {
+	 put(s.size());
+	 out += s;
+      }
+      void put_operator(const Operator& op) {
+	 auto it = operator_index.find(op.get_name());
+	 if (it == operator_index.end()) {
+	    it = operator_index.insert(std::make_pair(op.get_name(),
+	       operators.size())).first;
+	    operators.push_back(op.get_name());
+	 }
+	 put(it->second);
+      }
+      void put_filename(const std::string* name) {
+	 if (!name) {
+	    put(0); return;
+	 }
+	 /* different pointers may refer to equal filenames */
+	 auto it = filename_index.find(name);
+	 if (it == filename_index.end()) {
+	    std::uint64_t index = 0;
+	    for (std::size_t i = 0; i < filenames.size(); ++i) {
+	       if (*filenames[i] == *name) {
+		  index = i + 1; break;
+	       }
+	    }
+	    if (index == 0) {
+	       filenames.push_back(name);
+	       index = filenames.size();
+	    }
+	    it = filename_index.insert(std::make_pair(name, index)).first;
+	 }
+	 put(it->second);
+      }
+};
+
+struct MalformedData {};
+
+class Reader {
+   public:
+      Reader(const std::string& data) :
+	    cp(data.data()), end(data.data() + data.size()),
+	    filename(nullptr), line(0) {
+	 std::uint64_t count = get();
+	 while (count-- > 0) {
+	    operators.push_back(Operator(get_string()));
+	 }
+	 count = get();
+	 filenames.push_back(nullptr);
+	 while (count-- > 0) {
+	    filenames.push_back(intern_filename(get_string()));
+	 }
+      }
+
+      bool at_end() const {
+	 return cp == end;
+      }
+
+      NodePtr get_node() {
+	 std::uint64_t flags = get();
+	 if (flags & NULL_FLAG) return nullptr;
+	 if (flags & BEGIN_FILENAME_FLAG) {
+	    filename = get_filename();
+	 }
+	 line += get_signed();
+	 unsigned int column = get();
+	 Position begin(filename, line, column);
+	 const std::string* end_filename = filename;
+	 if (flags & END_FILENAME_FLAG) {
+	    end_filename = get_filename();
+	 }
+	 unsigned int end_line = line + get_signed();
+	 column = get();
+	 Location loc(begin, Position(end_filename, end_line, column));
+	 if (flags & LEAF_FLAG) {
+	    int tokenval = get_signed();
+	    return std::make_shared<Node>(loc,
+	       Token(tokenval, std::make_unique<std::string>(get_string())));
+	 }
+	 std::uint64_t index = get();
+	 if (index >= operators.size()) throw MalformedData();
+	 NodePtr node = std::make_shared<Node>(loc, operators[index]);
+	 std::uint64_t count = get();
+	 while (count-- > 0) {
+	    *node += get_node();
+	 }
+	 return node;
+      }
+
+   private:
+      const char* cp;
+      const char* end;
+      std::vector<Operator> operators;
+      std::vector<const std::string*> filenames;
+      const std::string* filename; // of the preceding node
+      std::int64_t line; // of the preceding node
+
+      std::uint64_t get() {
+	 std::uint64_t value = 0;
+	 unsigned int shift = 0;
+	 for(;;) {
+	    if (cp == end || shift > 63) throw MalformedData();
+	    unsigned char byte = *cp++;
+	    value |= std::uint64_t(byte & 0x7f) << shift;
+	    if (!(byte & 0x80)) return value;
+	    shift += 7;
+	 }
+      }
+      std::int64_t get_signed() {
+	 std::uint64_t value = get();
+	 return static_cast<std::int64_t>(value >> 1) ^
+	    -static_cast<std::int64_t>(value & 1);
+      }
+      std::string get_string() {
+	 std::uint64_t len = get();
+	 if (len > std::uint64_t(end - cp)) throw MalformedData();
+	 std::string s(cp, len);
+	 cp += len;
+	 return s;
+      }
+      const std::string* get_filename() {
+	 std::uint64_t index = get();
+	 if (index >= filenames.size()) throw MalformedData();
+	 return filenames[index];
+      }
+};
+
+// constructor ===============================================================
+
+AstCache::AstCache(const std::string& dir) : dir(dir) {
+   create_cache_dir(dir);
+}
+
+// accessors =================================================================
+
+NodePtr AstCache::load(const std::string& cpp_path,
+      const Args& args, const std::string& input_file) const {
+   CacheEntry entry(dir, get_kind("ast"), cpp_path, args, input_file);
+   std::string data;
+   if (!entry.load(data)) return nullptr;
+   return deserialize(data);
+}
+
+NodePtr AstCache::load(const std::string& cpp_path,
+      const Args& args, const std::string& input_file,
+      const SourceBuffer& output) const {
+   OutputCacheEntry entry(dir, get_kind("ast-output"), input_file,
+      output.begin(), output.end());
+   std::string data;
+   if (!entry.load(data)) return nullptr;
+   NodePtr root = deserialize(data);
+   if (root) {
+      /* the serialized tree is taken over as it is */
+      CacheEntry source_entry(dir, get_kind("ast"), cpp_path, args,
+	 input_file);
+      source_entry.store(output.begin(), output.end(), data);
+   }
+   return root;
+}
+
+void AstCache::store(const std::string& cpp_path,
+      const Args& args, const std::string& input_file,
+      const SourceBuffer& output, NodePtr root) const {
+   std::string data = serialize(root);
+   CacheEntry entry(dir, get_kind("ast"), cpp_path, args, input_file);
+   entry.store(output.begin(), output.end(), data);
+   OutputCacheEntry output_entry(dir, get_kind("ast-output"), input_file,
+      output.begin(), output.end());
+   output_entry.store(data);
+}
+
+// functions =================================================================
+
+std::string serialize(NodePtr root) {
+   Writer writer;
+   writer.put_node(root);
+   return writer.get_data();
+}
+
+NodePtr deserialize(const std::string& data) {
+   try {
+      Reader reader(data);
+      NodePtr root = reader.get_node();
+      if (!reader.at_end()) return nullptr;
+      return root;
+   } catch (MalformedData&) {
+      return nullptr;
+   }
+}
+
+} // namespace AstlC
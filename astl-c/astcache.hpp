@@ -0,0 +1,67 @@
+/*
+   Copyright (C) 2026 The Astl-C contributors
+   ----------------------------------------------------------------------------
+   Astl-C is free software; you can redistribute it
+   and/or modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either version
+   2 of the License, or (at your option) any later version.
+
+   Astl-C is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+
+#ifndef ASTL_C_ASTCACHE_H
+#define ASTL_C_ASTCACHE_H
+
+#include <string>
+#include <astl/syntax-tree.hpp>
+#include "buffer.hpp"
+#include "pp.hpp"
+
+namespace AstlC {
+
+   /* on-disk cache of syntax trees, see CacheEntry */
+   class AstCache {
+      public:
+	 // constructor
+	 AstCache(const std::string& dir);
+
+	 // accessors
+	 /* returns the cached syntax tree, if available,
+	    or nullptr otherwise */
+	 Astl::NodePtr load(const std::string& cpp_path,
+	    const Args& args, const std::string& input_file) const;
+	 /* returns the syntax tree that has been built from the
+	    same preprocessor output before, if available, or nullptr
+	    otherwise; this catches sources whose changes are not
+	    visible after preprocessing; a tree found is stored
+	    under the key of its source as well */
+	 Astl::NodePtr load(const std::string& cpp_path,
+	    const Args& args, const std::string& input_file,
+	    const SourceBuffer& output) const;
+	 /* store the syntax tree that has been built from
+	    the given preprocessor output */
+	 void store(const std::string& cpp_path,
+	    const Args& args, const std::string& input_file,
+	    const SourceBuffer& output, Astl::NodePtr root) const;
+
+      private:
+	 std::string dir;
+   };
+
+   /* compact binary representation of a syntax tree with
+      interned operators and filenames and delta-encoded locations */
+   std::string serialize(Astl::NodePtr root);
+   /* returns nullptr if data is malformed */
+   Astl::NodePtr deserialize(const std::string& data);
+
+} // namespace AstlC
+
+#endif
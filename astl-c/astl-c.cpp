@@ -16,16 +16,25 @@
    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
 */
 
+#include <atomic>
 #include <cassert>
 #include <cstdlib>
 #include <cstring>
+#include <exception>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <memory>
+#include <sstream>
+#include <thread>
+#include <vector>
 #include <astl/run.hpp>
 #include <astl/generator.hpp>
 #include <astl/loader.hpp>
+#include "arena.hpp"
+#include "astcache.hpp"
+#include "buffer.hpp"
+#include "cppcache.hpp"
 #include "scanner.hpp"
 #include "parser.hpp"
 #include "yytname.hpp"
@@ -33,6 +42,9 @@
 #include "location.hpp"
 #include "operators.hpp"
 #include "pp.hpp"
+#include "prefixcache.hpp"
+#include "preprocessor.hpp"
+#include "stats.hpp"
 
 using namespace std;
 using namespace Astl;
@@ -41,39 +53,78 @@ using namespace AstlC;
 class SyntaxTreeGeneratorForC: public SyntaxTreeGenerator {
    public:
       virtual NodePtr gen(int& argc, char**& argv) {
+	 /* in streaming mode, we are invoked once per source;
+	    the options are processed and the caches are set up
+	    just at the first invocation */
+	 if (configured) {
+	    argc -= consumed; argv += consumed;
+	    if (stats) stats->generating();
+	    return parse_next_source(units);
+	 }
+	 int original_argc = argc;
 	 Args args;
 	 if (argc == 0) {
 	    throw Exception("no source file given");
 	 }
-	 // prepare symbol table
-	 SymTable symtab;
-	 symtab.open();
-	 // insert non-ISO typedefs
-	 symtab.insert(Symbol(SC_TYPE, "__builtin_va_list"));
-	 // http://gcc.gnu.org/onlinedocs/gcc/Local-Labels.html
-	 symtab.insert(Symbol(SC_TYPE, "__label"));
-	 symtab.insert(Symbol(SC_TYPE, "__label__"));
-	 symtab.open();
 
-	 /* which C preprocessor is to be taken? */
-	 const char* cpp = "gcc";
-	 if (std::strcmp(*argv, "--cpp") == 0) {
-	    --argc; ++argv;
+	 /* which C preprocessor is to be taken and
+	    how are multiple sources to be processed? */
+	 for(;;) {
+	    if (std::strcmp(*argv, "--cpp") == 0) {
+	       --argc; ++argv;
+	       if (argc == 0) {
+		  throw Exception("argument for --cpp is missing");
+	       }
+	       cpp = *argv++; --argc;
+	    } else if (std::strcmp(*argv, "--builtin-cpp") == 0) {
+	       builtin = true; --argc; ++argv;
+	    } else if (std::strcmp(*argv, "--jobs") == 0) {
+	       jobs = get_count_option(argc, argv);
+	    } else if (std::strcmp(*argv, "--prefetch") == 0) {
+	       prefetch = get_count_option(argc, argv);
+	    } else if (std::strcmp(*argv, "--cpp-cache") == 0) {
+	       --argc; ++argv;
+	       if (argc == 0) {
+		  throw Exception("argument for --cpp-cache is missing");
+	       }
+	       cpp_cache = std::make_unique<CppCache>(*argv++); --argc;
+	    } else if (std::strcmp(*argv, "--stats") == 0) {
+	       if (!stats) stats = std::make_unique<Stats>();
+	       print_stats = true; --argc; ++argv;
+	    } else if (std::strcmp(*argv, "--stats-json") == 0) {
+	       --argc; ++argv;
+	       if (argc == 0) {
+		  throw Exception("argument for --stats-json is missing");
+	       }
+	       if (!stats) stats = std::make_unique<Stats>();
+	       stats_json = *argv++; --argc;
+	    } else if (std::strcmp(*argv, "--arena") == 0) {
+	       arena = true; --argc; ++argv;
+	    } else if (std::strcmp(*argv, "--share-headers") == 0) {
+	       prefix_cache = std::make_unique<PrefixCache>(); --argc; ++argv;
+	    } else if (std::strcmp(*argv, "--stream") == 0) {
+	       streaming = true; --argc; ++argv;
+	    } else if (std::strcmp(*argv, "--ast-cache") == 0) {
+	       --argc; ++argv;
+	       if (argc == 0) {
+		  throw Exception("argument for --ast-cache is missing");
+	       }
+	       ast_cache = std::make_unique<AstCache>(*argv++); --argc;
+	    } else {
+	       break;
+	    }
 	    if (argc == 0) {
-	       throw Exception("argument for --cpp is missing");
+	       throw Exception("no source file given");
 	    }
-	    cpp = *argv++; --argc;
 	 }
+	 if (builtin) builtin_cpp = std::make_unique<Preprocessor>(cpp);
+	 if (stats) stats->generating();
 
 	 /* multiple sources to be processed? */
 	 bool multiple_sources = false;
-	 std::size_t source_count = 0;
-	 NodePtr super_root; // collecting multiple sources
 	 if (std::strcmp(*argv, "--sources--") == 0) {
 	    multiple_sources = true;
 	    --argc; ++argv;
-	    super_root = std::make_shared<Node>(Location(),
-	       Operator("translation_units"));
 	 }
 
 	 /* process options and source files */
@@ -98,7 +149,7 @@ class SyntaxTreeGeneratorForC: public SyntaxTreeGenerator {
 	    }
 	    /* end this if we are running out of arguments */
 	    if (argc == 0) {
-	       if (multiple_sources && source_count > 0) {
+	       if (multiple_sources && units.size() > 0) {
 		  throw Exception("closing --sources-- is missing");
 	       } else {
 		  throw Exception("no source file given");
@@ -107,54 +158,475 @@ class SyntaxTreeGeneratorForC: public SyntaxTreeGenerator {
 	    /* leave loop,
 	       if sources were given and the source list is closed */
 	    if (multiple_sources && std::strcmp(*argv, "--sources--") == 0) {
-	       if (source_count == 0) {
+	       if (units.size() == 0) {
 		  throw Exception("no source files given");
 	       }
 	       break;
 	    }
-	    ++source_count;
 	    /* take source file name */
 	    char* source_name = *argv++; --argc;
 
-
 	    // various definitions to hack around non-ISO constructs
-	    // that are imported from various gcc headers
-	    args.push_back("-D__extension__=");
-
-	    /* pass the source through the preprocessor */
-	    cpp_istream source(cpp, args, source_name);
-	    if (!source) {
-	       std::ostringstream os;
-	       os << "unable to open " << source_name << " for reading";
-	       throw Exception(os.str());
+	    // that are imported from various gcc headers;
+	    // added just once such that sources with the same options
+	    // share the configuration of the built-in preprocessor
+	    Args unit_args(args);
+	    unit_args.push_back("-D__extension__=");
+
+	    /* the preprocessor options seen so far apply to this source */
+	    units.push_back(TranslationUnit{source_name, unit_args, nullptr});
+	 } while (multiple_sources);
+	 configured = true;
+	 consumed = original_argc - argc;
+
+	 if (!multiple_sources) {
+	    NodePtr root = parse_source(units[0]);
+	    collect_stats(units);
+	    return root;
+	 }
+	 if (streaming) {
+	    return parse_next_source(units);
+	 }
+	 parse_sources(units);
+	 NodePtr super_root = std::make_shared<Node>(Location(),
+	    Operator("translation_units"));
+	 /* the trees are owned by the super root only such that
+	    they are released as soon as the script drops them */
+	 for (auto& unit: units) {
+	    *super_root += unit.root;
+	    unit.root = nullptr;
+	 }
+	 collect_stats(units);
+	 return super_root;
+      }
+
+      /* true if the script is to be run once more for
+	 the next source in streaming mode */
+      bool more_sources() const {
+	 return streaming && next_unit < unit_count;
+      }
+
+      /* to be invoked when the script has been executed */
+      void report_stats() {
+	 if (!stats) return;
+	 stats->finish();
+	 if (print_stats) {
+	    stats->print(std::cerr);
+	 }
+	 if (stats_json) {
+	    std::ofstream out(stats_json);
+	    stats->print_json(out);
+	    if (!out) {
+	       std::cerr << "astl-c: unable to write " << stats_json <<
+		  std::endl;
 	    }
+	 }
+      }
+
+   private:
+      struct TranslationUnit {
+	 std::string source_name;
+	 Args args; // preprocessor options for this source
+	 NodePtr root;
+	 SourceStats stats; // filled in if statistics are requested
+      };
+
+      const char* cpp = "gcc"; // preprocessor to be invoked
+      bool builtin = false; // use the built-in preprocessor
+      std::unique_ptr<Preprocessor> builtin_cpp; // if builtin is set
+      unsigned int jobs = 1; // number of sources parsed in parallel
+      unsigned int prefetch = 0; // number of sources preprocessed ahead
+      std::unique_ptr<CppCache> cpp_cache; // optional
+      std::unique_ptr<AstCache> ast_cache; // optional
+      std::unique_ptr<PrefixCache> prefix_cache; // optional
+      bool arena = false; // allocate the nodes of each tree in an arena
+      std::unique_ptr<Stats> stats; // optional
+      bool print_stats = false; // on standard error
+      const char* stats_json = nullptr; // file for stats in JSON format
+      bool configured = false; // options have been processed
+      int consumed = 0; // number of arguments taken by gen
+      std::vector<TranslationUnit> units; // sources to be processed
+      bool streaming = false; // one source per script run
+      std::size_t next_unit = 0; // next source to be parsed if streaming
+      std::size_t unit_count = 0; // number of sources if streaming
+
+      /* fetch the positive integer argument of an option like --jobs */
+      static unsigned int get_count_option(int& argc, char**& argv) {
+	 const char* option = *argv++; --argc;
+	 if (argc == 0) {
+	    std::ostringstream os;
+	    os << "argument for " << option << " is missing";
+	    throw Exception(os.str());
+	 }
+	 std::istringstream is(*argv++); --argc;
+	 unsigned int count;
+	 if (!(is >> count) || count < 1) {
+	    std::ostringstream os;
+	    os << "invalid argument for " << option;
+	    throw Exception(os.str());
+	 }
+	 return count;
+      }
+
+      /* throw an exception if the preprocessor failed for a unit */
+      static void check_preprocessing(const TranslationUnit& unit,
+	    bool success) {
+	 if (!success) {
+	    std::ostringstream os;
+	    os << "preprocessing of " << unit.source_name << " failed";
+	    throw Exception(os.str());
+	 }
+      }
 
-	    /* accept locale from environment if it works out */
-	    std::unique_ptr<std::locale> locale = nullptr;
-	    try {
-	       locale = std::make_unique<std::locale>("");
-	    } catch (std::runtime_error&) {
-	       locale = nullptr;
+      /* record the statistics of a syntax tree taken from the cache */
+      static void cached_stats(TranslationUnit& unit, const NodePtr& root) {
+	 unit.stats.cached = true;
+	 unit.stats.nodes = count_nodes(root);
+      }
+
+      /* pass the statistics of all units in their original order */
+      void collect_stats(const std::vector<TranslationUnit>& units) {
+	 if (!stats) return;
+	 for (auto& unit: units) {
+	    stats->add(unit.source_name, unit.stats);
+	 }
+	 stats->generated();
+      }
+
+      static position to_position(const Astl::Position& pos) {
+	 return position(pos.filename, pos.line, pos.column);
+      }
+
+      /* what the scanners of one source have in common */
+      struct ScanContext {
+	 const std::string& source_name;
+	 const std::locale& locale;
+	 NodeArena* arena; // optional
+	 std::size_t tokens; // scanned so far
+	 double scan_time; // spent so far, if timing is enabled
+      };
+
+      /* parse the preprocessed source;
+	 everything that is modified during parsing is local to this
+	 invocation such that multiple sources can be parsed in parallel,
+	 with the exception of the thread-safe prefix cache */
+      NodePtr parse_source(const SourceBuffer& source,
+	    TranslationUnit& unit) const {
+	 /* accept locale from environment if it works out */
+	 std::unique_ptr<std::locale> locale = nullptr;
+	 try {
+	    locale = std::make_unique<std::locale>("");
+	 } catch (std::runtime_error&) {
+	    locale = nullptr;
+	 }
+	 /* the arena lives on as long as any of its nodes */
+	 NodeArenaPtr node_arena(arena? new NodeArena(): nullptr);
+	 ScanContext context{unit.source_name,
+	    locale? *locale: std::locale(), node_arena.get(), 0, 0};
+	 Stopwatch stopwatch;
+	 NodePtr root;
+	 if (prefix_cache) {
+	    root = parse_with_prefix(source, context);
+	 } else {
+	    root = parse_range(source.begin(), source.end(),
+	       nullptr, nullptr, context);
+	 }
+	 if (stats) {
+	    unit.stats.parse_time = stopwatch.get_wall_time();
+	    unit.stats.parse_cpu_time = stopwatch.get_cpu_time();
+	    unit.stats.scan_time = context.scan_time;
+	    unit.stats.tokens = context.tokens;
+	    unit.stats.cpp_bytes = source.size();
+	    unit.stats.nodes = count_nodes(root);
+	 }
+	 return root;
+      }
+
+      /* parse [begin, end) of a preprocessed source which consists
+	 of complete external declarations and which follows
+	 the given prefix, if any; the file-scope symbols
+	 of the range are appended to kept, if given */
+      NodePtr parse_range(const char* begin, const char* end,
+	    const PrefixCache::Prefix* prefix, std::vector<Symbol>* kept,
+	    ScanContext& context) const {
+	 // prepare symbol table
+	 SymTable symtab;
+	 symtab.open();
+	 // insert non-ISO typedefs
+	 symtab.insert(Symbol(SC_TYPE, "__builtin_va_list"));
+	 // http://gcc.gnu.org/onlinedocs/gcc/Local-Labels.html
+	 symtab.insert(Symbol(SC_TYPE, "__label"));
+	 symtab.insert(Symbol(SC_TYPE, "__label__"));
+	 symtab.open();
+	 if (prefix) {
+	    for (auto& symbol: prefix->symbols) {
+	       symtab.insert(symbol);
+	    }
+	 }
+	 if (kept) symtab.keep_next_scope(*kept);
+
+	 /* run the output of the preprocessor through our scanner ... */
+	 Scanner scanner(begin, end, context.source_name, symtab,
+	    context.locale, context.arena);
+	 if (prefix && !prefix->declarations.empty()) {
+	    /* empty rules at the beginning get the same locations
+	       as if the prefix had been parsed together with the range */
+	    scanner.set_origin(to_position(
+	       prefix->declarations.back()->get_location().end));
+	 }
+	 if (stats) scanner.enable_timing();
+	 /* ... and parse it */
+	 NodePtr root;
+	 parser p(scanner, symtab, root);
+	 if (p.parse() != 0) {
+	    std::ostringstream os;
+	    os << "parsing of " << context.source_name << " failed";
+	    throw Exception(os.str());
+	 }
+	 context.tokens += scanner.get_token_count();
+	 context.scan_time += scanner.get_scan_time();
+	 return root;
+      }
+
+      /* parse the preprocessed source where the headers included
+	 at its beginning are taken from the prefix cache, as far as
+	 possible, and put into the cache otherwise */
+      NodePtr parse_with_prefix(const SourceBuffer& source,
+	    ScanContext& context) const {
+	 auto cuts = PrefixCache::get_cuts(source.begin(), source.end(),
+	    context.source_name);
+	 /* look for the longest prefix parsed before */
+	 std::size_t index = cuts.size();
+	 PrefixCache::PrefixPtr prefix;
+	 while (index > 0 &&
+	       !(prefix = prefix_cache->lookup(cuts[index-1].fingerprint))) {
+	    --index;
+	 }
+	 const char* begin = source.begin();
+	 if (index > 0) begin += cuts[index-1].offset;
+	 /* parse the remaining headers one by one
+	    such that other sources can share them */
+	 for (; index < cuts.size(); ++index) {
+	    const char* end = source.begin() + cuts[index].offset;
+	    auto next = std::make_shared<PrefixCache::Prefix>();
+	    if (prefix) *next = *prefix;
+	    NodePtr root = parse_range(begin, end, prefix.get(),
+	       &next->symbols, context);
+	    for (std::size_t i = 0; i < root->size(); ++i) {
+	       next->declarations.push_back(root->get_operand(i));
 	    }
-	    if (locale) source.imbue(*locale);
-	    /* run the output of the preprocessor through our scanner ... */
-	    Scanner scanner(source, source_name, symtab);
-	    /* ... and parse it */
-	    NodePtr root;
-	    parser p(scanner, symtab, root);
-	    if (p.parse() != 0) {
-	       std::ostringstream os;
-	       os << "parsing of " << source_name << " failed";
-	       throw Exception(os.str());
+	    prefix = prefix_cache->insert(cuts[index].fingerprint, next);
+	    begin = end;
+	 }
+	 NodePtr tail = parse_range(begin, source.end(), prefix.get(),
+	    nullptr, context);
+	 if (!prefix || prefix->declarations.empty()) return tail;
+	 /* the location is the same as if the source had been parsed
+	    at once, i.e. it begins with the initial location */
+	 location loc;
+	 if (tail->size() > 0) {
+	    loc.end = to_position(tail->get_location().end);
+	 } else {
+	    loc.end = to_position(
+	       prefix->declarations.back()->get_location().end);
+	 }
+	 NodePtr root = make_node(context.arena, make_loc(loc),
+	    Op::translation_unit);
+	 /* each source gets its own copy of the cached declarations
+	    as scripts may set attributes or transform the trees */
+	 for (auto& declaration: prefix->declarations) {
+	    *root += copy_tree(context.arena, declaration);
+	 }
+	 for (std::size_t i = 0; i < tail->size(); ++i) {
+	    *root += tail->get_operand(i);
+	 }
+	 return root;
+      }
+
+      /* deep copy of a syntax tree */
+      static NodePtr copy_tree(NodeArena* arena, const NodePtr& node) {
+	 if (!node) return nullptr;
+	 if (node->is_leaf()) {
+	    const Token& token = node->get_token();
+	    return make_node(arena, node->get_location(),
+	       Token(token.get_tokenval(),
+		  std::make_unique<std::string>(token.get_text())));
+	 }
+	 NodePtr copy = make_node(arena, node->get_location(),
+	    node->get_op());
+	 for (std::size_t i = 0; i < node->size(); ++i) {
+	    *copy += copy_tree(arena, node->get_operand(i));
+	 }
+	 return copy;
+      }
+
+      /* the built-in preprocessor lays out its output differently
+	 and must therefore not share cached trees with cpp */
+      std::string cache_key() const {
+	 if (builtin_cpp) return std::string(cpp) + " (builtin)";
+	 return cpp;
+      }
+
+      /* parse the preprocessed source unless the same output
+	 has been parsed before and store the resulting syntax tree
+	 in the cache, if requested */
+      NodePtr parse_preprocessed_source(const SourceBuffer& source,
+	    TranslationUnit& unit) const {
+	 if (ast_cache) {
+	    NodePtr root = ast_cache->load(cache_key(), unit.args,
+	       unit.source_name, source);
+	    if (root) {
+	       if (stats) cached_stats(unit, root);
+	       return root;
+	    }
+	 }
+	 NodePtr root = parse_source(source, unit);
+	 if (ast_cache) {
+	    ast_cache->store(cache_key(), unit.args, unit.source_name,
+	       source, root);
+	 }
+	 return root;
+      }
+
+      /* pass a source through the preprocessor and parse it
+	 unless its syntax tree is found in the cache */
+      NodePtr parse_source(TranslationUnit& unit) const {
+	 if (ast_cache) {
+	    NodePtr root = ast_cache->load(cache_key(), unit.args,
+	       unit.source_name);
+	    if (root) {
+	       if (stats) cached_stats(unit, root);
+	       return root;
 	    }
-	    if (multiple_sources) {
-	       *super_root += root;
+	 }
+	 Stopwatch stopwatch;
+	 if (builtin_cpp) {
+	    bool success;
+	    SourceBuffer buffer(builtin_cpp->preprocess(unit.args,
+	       unit.source_name, success));
+	    check_preprocessing(unit, success);
+	    unit.stats.preprocess_time = stopwatch.get_wall_time();
+	    unit.stats.preprocess_cpu_time = stopwatch.get_cpu_time();
+	    return parse_preprocessed_source(buffer, unit);
+	 }
+	 if (cpp_cache || ast_cache) {
+	    std::string output;
+	    bool success;
+	    if (cpp_cache) {
+	       output = cpp_cache->preprocess(cpp,
+		  unit.args, unit.source_name, success,
+		  &unit.stats.preprocess_cpu_time);
 	    } else {
-	       super_root = root;
+	       output = preprocess(cpp, unit.args, unit.source_name, success,
+		  &unit.stats.preprocess_cpu_time);
 	    }
-	 } while (multiple_sources);
+	    check_preprocessing(unit, success);
+	    SourceBuffer buffer(std::move(output));
+	    unit.stats.preprocess_time = stopwatch.get_wall_time();
+	    return parse_preprocessed_source(buffer, unit);
+	 }
+	 cpp_istream source(cpp, unit.args, unit.source_name);
+	 if (!source) {
+	    std::ostringstream os;
+	    os << "unable to open " << unit.source_name << " for reading";
+	    throw Exception(os.str());
+	 }
+	 /* the scanner works on the entire output of the preprocessor */
+	 SourceBuffer buffer(source);
+	 unit.stats.preprocess_cpu_time = source.finish();
+	 unit.stats.preprocess_time = stopwatch.get_wall_time();
+	 return parse_source(buffer, unit);
+      }
+
+      /* parse just the next unit in streaming mode; its tree is the
+	 only operand of the super root such that scripts see the
+	 same structure as in the regular mode */
+      NodePtr parse_next_source(std::vector<TranslationUnit>& units) {
+	 unit_count = units.size();
+	 TranslationUnit& unit = units[next_unit++];
+	 NodePtr super_root = std::make_shared<Node>(Location(),
+	    Operator("translation_units"));
+	 *super_root += parse_source(unit);
+	 if (stats) {
+	    stats->add(unit.source_name, unit.stats);
+	    stats->generated();
+	 }
 	 return super_root;
       }
+
+      /* parse all units, the results are stored in the units
+	 such that their original order is preserved */
+      void parse_sources(std::vector<TranslationUnit>& units) const {
+	 if (jobs > 1 && units.size() > 1) {
+	    parse_sources_in_parallel(units);
+	 } else if (prefetch > 0 && !builtin_cpp) {
+	    parse_prefetched_sources(units);
+	 } else {
+	    for (auto& unit: units) {
+	       unit.root = parse_source(unit);
+	    }
+	 }
+      }
+
+      /* parse all units using up to jobs threads */
+      void parse_sources_in_parallel(
+	    std::vector<TranslationUnit>& units) const {
+	 unsigned int nthreads = jobs;
+	 if (nthreads > units.size()) nthreads = units.size();
+	 std::vector<std::exception_ptr> errors(units.size());
+	 std::atomic<std::size_t> next(0);
+	 std::atomic<bool> failed(false);
+	 auto worker = [&]() {
+	    std::size_t index;
+	    while (!failed && (index = next++) < units.size()) {
+	       try {
+		  units[index].root = parse_source(units[index]);
+	       } catch (...) {
+		  errors[index] = std::current_exception();
+		  failed = true;
+	       }
+	    }
+	 };
+	 std::vector<std::thread> threads;
+	 for (unsigned int i = 0; i < nthreads; ++i) {
+	    threads.emplace_back(worker);
+	 }
+	 for (auto& thread: threads) {
+	    thread.join();
+	 }
+	 /* report the first failure in the order of the sources */
+	 for (auto& error: errors) {
+	    if (error) std::rethrow_exception(error);
+	 }
+      }
+
+      /* parse all units sequentially while the preprocessor
+	 works on up to prefetch sources ahead */
+      void parse_prefetched_sources(
+	    std::vector<TranslationUnit>& units) const {
+	 cpp_prefetcher prefetcher(cpp, prefetch, cpp_cache.get());
+	 for (auto& unit: units) {
+	    if (ast_cache) {
+	       unit.root = ast_cache->load(cache_key(), unit.args,
+		  unit.source_name);
+	       if (unit.root) {
+		  if (stats) cached_stats(unit, unit.root);
+		  continue;
+	       }
+	    }
+	    prefetcher.add(unit.args, unit.source_name);
+	 }
+	 for (auto& unit: units) {
+	    if (unit.root) continue; // taken from the cache
+	    Stopwatch stopwatch;
+	    bool success;
+	    SourceBuffer source(prefetcher.next(success,
+	       &unit.stats.preprocess_cpu_time));
+	    check_preprocessing(unit, success);
+	    unit.stats.preprocess_time = stopwatch.get_wall_time();
+	    unit.root = parse_preprocessed_source(source, unit);
+	 }
+      }
 };
 
 int main(int argc, char** argv) {
@@ -185,7 +657,11 @@ int main(int argc, char** argv) {
 	    loader.add_library("/usr/share/astl/astl");
 	 #endif
       }
-      run(argc, argv, astgen, loader, Op::LPAREN);
+      /* in streaming mode, the script is run once per source */
+      do {
+	 run(argc, argv, astgen, loader, Op::LPAREN);
+      } while (astgen.more_sources());
+      astgen.report_stats();
    } catch (Exception& e) {
       cout << endl;
       cerr << e.what() << endl;
@@ -203,11 +679,11 @@ astl-c -- run Astl scripts for C99 sources
 
 =head1 SYNOPSIS
 
-B<astl-c> F<astl-script> [B<--cpp> preprocessor] [gcc preprocessor options...] F<C-source> [I<args>]
+B<astl-c> F<astl-script> [B<--cpp> preprocessor] [B<--builtin-cpp>] [B<--cpp-cache> I<dir>] [B<--ast-cache> I<dir>] [B<--arena>] [B<--stats>] [B<--stats-json> I<file>] [gcc preprocessor options...] F<C-source> [I<args>]
 
-B<astl-c> F<astl-script> [B<--cpp> preprocessor] [B<--cpp--> gcc preprocessor options... B<--cpp-->] F<C-source> [I<args>]
+B<astl-c> F<astl-script> [B<--cpp> preprocessor] [B<--builtin-cpp>] [B<--cpp-cache> I<dir>] [B<--ast-cache> I<dir>] [B<--arena>] [B<--stats>] [B<--stats-json> I<file>] [B<--cpp--> gcc preprocessor options... B<--cpp-->] F<C-source> [I<args>]
 
-B<astl-c> F<astl-script> [B<--cpp> preprocessor] B<--sources--> sources and gcc preprocessor options B<--sources--> [I<args>]
+B<astl-c> F<astl-script> [B<--cpp> preprocessor] [B<--builtin-cpp>] [B<--cpp-cache> I<dir>] [B<--ast-cache> I<dir>] [B<--arena>] [B<--stats>] [B<--stats-json> I<file>] [B<--jobs> I<n>] [B<--prefetch> I<n>] [B<--stream>] [B<--share-headers>] B<--sources--> sources and gcc preprocessor options B<--sources--> [I<args>]
 
 =head1 DESCRIPTION
 
@@ -227,6 +703,50 @@ If some of the preprocessor options
 do not begin with a `-' character, the whole set of gcc preprocessor
 options needs to be enclosed in ``--cpp--'' .. ``--cpp--''.
 
+The option B<--builtin-cpp> replaces the external preprocessor
+by a preprocessor built into F<astl-c> which saves a process per
+source and reads and tokenizes each included file just once for all
+sources of a B<--sources--> list. Headers protected by an include
+guard or by ``#pragma once'' are skipped without being rescanned when they are
+included a second time. The external preprocessor (see B<--cpp>)
+is still invoked once for each distinct set of preprocessor options
+to learn its predefined macros and its include search path.
+The built-in preprocessor preserves the columns of all tokens
+unless they follow a macro expansion on the same line.
+Predicates like I<__has_attribute> and I<__has_builtin> always
+evaluate to 0. B<--cpp-cache> and B<--prefetch> have no effect in
+combination with B<--builtin-cpp>.
+
+The option B<--cpp-cache> keeps the output of the preprocessor in
+the given directory which is created if it does not exist yet.
+Cached output is reused without invoking the preprocessor
+if the preprocessor (including the size and modification time of
+its executable), its options, the environment variables
+B<CPATH>, B<C_INCLUDE_PATH>, and B<GCC_EXEC_PREFIX>, and the name
+and contents of the source are the same, and if none of the files named in the
+line markers of the cached output, i.e. all included files, has
+been changed since. Output of failed preprocessor runs is not cached.
+
+Likewise, the option B<--ast-cache> keeps the abstract syntax
+trees of the sources in a compact binary representation in the
+given directory. Under the same conditions, a cached syntax tree is
+taken as it is and neither the preprocessor nor the parser are invoked.
+Otherwise, if the preprocessor delivers the same output for
+the source as in an earlier run, the syntax tree of that run is
+reused and just the parser is skipped. Hence, after touching
+a few sources of a large project, just those whose preprocessed
+output has actually changed are parsed again.
+Cached syntax trees are not taken by other builds of B<astl-c>.
+Both caches may share the same directory.
+
+The option B<--arena> allocates all nodes of the abstract syntax
+tree of a source from large blocks instead of allocating each of
+them individually. The blocks are released together when the
+last node of the tree is gone. This speeds up parsing and
+improves the locality of the nodes but nodes which are dropped
+by the script do not free any memory as long as other nodes
+of the same tree are still in use.
+
 In addition, following defines are added to convert various gcc-specific
 constructs found in the gcc headers to ISO C:
 
@@ -249,6 +769,19 @@ Once the abstract syntax tree is present, the Astl script is
 loaded and executed following the execution order defined
 in section 12.5 of the Report of the Astl Programming Language.
 
+The option B<--stats> prints statistics on standard error when the
+script has been executed. The wall clock time needed for
+preprocessing and parsing (which includes scanning), the CPU time
+of the preprocessor (or of the built-in preprocessor)
+and for parsing, the numbers of tokens and nodes, and the size of
+the preprocessor output are reported for each source and in total.
+For the whole run, the time needed to generate the abstract syntax
+trees, the CPU time of all preprocessor processes, the time for
+loading and executing the script, and the peak resident set size
+are reported. The option B<--stats-json> writes the same figures in
+JSON format to the given file, with times given in seconds.
+Timing the scanner slows down parsing a little.
+
 All arguments behind the C source file are put into a list
 and bound to the variable I<args> in the I<main> function.
 
@@ -259,6 +792,46 @@ gcc preprocessor and subsequently parsed. All resulting
 abstract syntax trees are then put under a root node in their
 original order with ``translation_units'' as operator.
 
+The option B<--jobs> allows up to I<n> sources of a B<--sources--> list
+to be preprocessed and parsed in parallel. Each source gets its
+own preprocessor, scanner, parser, and symbol table. The order of
+the abstract syntax trees below the ``translation_units'' node
+remains the order of the command line. If multiple sources fail
+to parse, the failure of the source which comes first
+on the command line is reported.
+
+Alternatively, the sources can be parsed one after another while
+the option B<--prefetch> keeps up to I<n> preprocessors running ahead
+whose output is buffered in memory. This hides the latency of
+the preprocessor behind the parsing of the current source.
+In this case, the preprocessing time reported by B<--stats>
+for a source is the time spent waiting for its preprocessor.
+B<--prefetch> has no effect in combination with B<--jobs>.
+
+The option B<--stream> runs the script once for each source of
+a B<--sources--> list instead of once for all of them. Each run
+sees a ``translation_units'' node with the abstract syntax tree
+of just one source, and this tree is released before the next
+source is parsed. This bounds the memory by the largest source
+instead of the sum of all sources but is suitable only for scripts
+that look at one translation unit at a time. Sources are then
+parsed one after another, i.e. B<--jobs> and B<--prefetch> have
+no effect in combination with B<--stream>.
+
+The option B<--share-headers> parses the headers included at the
+beginning of a source just once for all sources of a B<--sources-->
+list that include the same headers in the same order with the same
+preprocessor options, similar to precompiled headers. The preprocessed
+output of each source is split at the points where the source
+itself continues after a top-level #include. The longest sequence
+of such headers that has been parsed before is taken over together
+with the typedef names declared therein, and just the rest of the
+source is parsed. The resulting abstract syntax trees are the same
+as without this option. Each source gets its own copy of the subtrees
+of the shared headers such that attributes and transformations of
+the script apply to one source only. The parsed headers are kept
+until the end of the run, even in combination with B<--stream>.
+
 =head1 EXAMPLE
 
 The following example prints a warning message for each
@@ -295,7 +868,8 @@ spacing even for input lines which otherwise remain untouched.
 One option is to use the preprocessor option F<-traditional-cpp>
 which preserves spacing to the extent possible but which unfortunately
 does not support preprocessor features of ISO C like stringify
-operators.
+operators. Alternatively, the option B<--builtin-cpp> selects a
+preprocessor which keeps the original columns.
 
 =head1 AUTHOR
 
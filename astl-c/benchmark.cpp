@@ -0,0 +1,156 @@
+/*
+   Copyright (C) 2026 The Astl-C contributors
+   ----------------------------------------------------------------------------
+   Astl-C is free software; you can redistribute it
+   and/or modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either version
+   2 of the License, or (at your option) any later version.
+
+   Astl-C is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+/*
+   benchmark of the scanner and the parser:
+   each source is scanned and parsed repeatedly, the
+   best times are reported together with the peak memory usage
+*/
+
+#include <sys/resource.h>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <astl/exception.hpp>
+#include <astl/syntax-tree.hpp>
+#include "arena.hpp"
+#include "buffer.hpp"
+#include "location.hpp"
+#include "parser.hpp"
+#include "scanner.hpp"
+#include "stats.hpp"
+#include "symtable.hpp"
+
+using namespace Astl;
+using namespace AstlC;
+
+typedef std::chrono::steady_clock Clock;
+
+/* number of seconds elapsed since start */
+static double since(Clock::time_point start) {
+   return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+static std::size_t scan(const SourceBuffer& source,
+      const std::string& name) {
+   SymTable symtab;
+   symtab.open();
+   Scanner scanner(source, name, symtab);
+   AstlC::location loc;
+   semantic_type yylval;
+   std::size_t tokens = 0;
+   while (scanner.get_token(yylval, loc) != 0) {
+      ++tokens;
+   }
+   return tokens;
+}
+
+static NodePtr parse(const SourceBuffer& source, const std::string& name,
+      bool with_arena) {
+   SymTable symtab;
+   symtab.open();
+   symtab.insert(Symbol(SC_TYPE, "__builtin_va_list"));
+   symtab.open();
+   NodeArenaPtr arena(with_arena? new NodeArena(): nullptr);
+   Scanner scanner(source, name, symtab, std::locale(), arena.get());
+   NodePtr root;
+   parser p(scanner, symtab, root);
+   if (p.parse() != 0) {
+      std::ostringstream os;
+      os << "parsing of " << name << " failed";
+      throw Exception(os.str());
+   }
+   return root;
+}
+
+/* peak resident set size in kbytes */
+static long peak_rss() {
+   struct rusage usage;
+   if (getrusage(RUSAGE_SELF, &usage) < 0) return 0;
+   return usage.ru_maxrss;
+}
+
+int main(int argc, char** argv) {
+   char* cmdname = *argv++; --argc;
+   unsigned int repetitions = 5;
+   bool with_arena = false;
+   while (argc > 0 && **argv == '-') {
+      if (std::strcmp(*argv, "-a") == 0) {
+	 with_arena = true;
+	 --argc; ++argv;
+      } else if (std::strcmp(*argv, "-r") == 0 && argc > 1 &&
+	    std::atoi(argv[1]) > 0) {
+	 repetitions = std::atoi(argv[1]);
+	 argc -= 2; argv += 2;
+      } else {
+	 argc = 0;
+      }
+   }
+   if (argc == 0) {
+      std::cerr << "Usage: " << cmdname <<
+	 " [-a] [-r repetitions] filename..." << std::endl;
+      exit(1);
+   }
+
+   std::cout << std::left << std::setw(24) << "source" << std::right <<
+      std::setw(8) << "MB" <<
+      std::setw(10) << "scan MB/s" << std::setw(12) << "tokens/s" <<
+      std::setw(11) << "parse MB/s" << std::setw(12) << "nodes/s" <<
+      std::endl;
+   std::cout << std::fixed;
+   try {
+      for (; argc > 0; --argc, ++argv) {
+	 std::string name(*argv);
+	 SourceBuffer source(name);
+	 double mbytes = source.size() / 1e6;
+	 std::size_t tokens = 0; std::size_t nodes = 0;
+	 double scan_time = 0; double parse_time = 0;
+	 for (unsigned int i = 0; i < repetitions; ++i) {
+	    auto start = Clock::now();
+	    tokens = scan(source, name);
+	    double t = since(start);
+	    if (i == 0 || t < scan_time) scan_time = t;
+
+	    start = Clock::now();
+	    NodePtr root = parse(source, name, with_arena);
+	    t = since(start);
+	    if (i == 0 || t < parse_time) parse_time = t;
+	    nodes = count_nodes(root);
+	 }
+	 std::cout << std::left << std::setw(24) << name << std::right <<
+	    std::setprecision(2) << std::setw(8) << mbytes <<
+	    std::setprecision(1) <<
+	    std::setw(10) << mbytes / scan_time <<
+	    std::setprecision(0) <<
+	    std::setw(12) << tokens / scan_time <<
+	    std::setprecision(1) <<
+	    std::setw(11) << mbytes / parse_time <<
+	    std::setprecision(0) <<
+	    std::setw(12) << nodes / parse_time << std::endl;
+      }
+   } catch (Exception& e) {
+      std::cerr << cmdname << ": " << e.what() << std::endl;
+      exit(1);
+   }
+   std::cout << "peak RSS: " << peak_rss() << " kB" << std::endl;
+}
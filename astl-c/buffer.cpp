@@ -0,0 +1,99 @@
+/*
+   Copyright (C) 2026 The Astl-C contributors
+   ----------------------------------------------------------------------------
+   Astl-C is free software; you can redistribute it
+   and/or modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either version
+   2 of the License, or (at your option) any later version.
+
+   Astl-C is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <sstream>
+#include <astl/exception.hpp>
+#include "buffer.hpp"
+
+namespace AstlC {
+
+// constructors ==============================================================
+
+SourceBuffer::SourceBuffer(const std::string& filename) :
+      mapped(nullptr), mapped_size(0) {
+   int fd = open(filename.c_str(), O_RDONLY);
+   struct stat statbuf;
+   if (fd < 0 || fstat(fd, &statbuf) < 0) {
+      if (fd >= 0) close(fd);
+      std::ostringstream os;
+      os << "unable to open " << filename << " for reading";
+      throw Astl::Exception(os.str());
+   }
+   if (S_ISREG(statbuf.st_mode) && statbuf.st_size > 0) {
+      void* addr = mmap(nullptr, statbuf.st_size, PROT_READ,
+	 MAP_PRIVATE, fd, 0);
+      if (addr != MAP_FAILED) {
+	 mapped = addr; mapped_size = statbuf.st_size;
+      }
+   }
+   if (!mapped) {
+      /* not mappable (empty file, pipe, ...): read it instead */
+      char buf[65536];
+      ssize_t nbytes;
+      while ((nbytes = read(fd, buf, sizeof buf)) > 0) {
+	 contents.append(buf, nbytes);
+      }
+   }
+   close(fd);
+}
+
+SourceBuffer::SourceBuffer(std::istream& in) :
+      mapped(nullptr), mapped_size(0) {
+   char buf[65536];
+   while (in.read(buf, sizeof buf) || in.gcount() > 0) {
+      contents.append(buf, in.gcount());
+   }
+}
+
+SourceBuffer::SourceBuffer(std::string&& contents) :
+      contents(std::move(contents)), mapped(nullptr), mapped_size(0) {
+}
+
+SourceBuffer::~SourceBuffer() {
+   if (mapped) {
+      munmap(mapped, mapped_size);
+   }
+}
+
+// accessors =================================================================
+
+const char* SourceBuffer::begin() const {
+   if (mapped) {
+      return static_cast<const char*>(mapped);
+   } else {
+      return contents.data();
+   }
+}
+
+const char* SourceBuffer::end() const {
+   return begin() + size();
+}
+
+std::size_t SourceBuffer::size() const {
+   if (mapped) {
+      return mapped_size;
+   } else {
+      return contents.size();
+   }
+}
+
+} // namespace AstlC
@@ -1,5 +1,5 @@
 /*
-   Copyright (C) 2009-2016 Andreas Franz Borchert
+   Copyright (C) 2026 The Astl-C contributors
    ----------------------------------------------------------------------------
    Astl-C is free software; you can redistribute it
    and/or modify it under the terms of the GNU Library General Public
@@ -16,53 +16,37 @@
    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
 */
 
-#ifndef ASTL_C_SCOPE_H
-#define ASTL_C_SCOPE_H
+#ifndef ASTL_C_BUFFER_H
+#define ASTL_C_BUFFER_H
 
-#include <map>
+#include <cstddef>
+#include <iostream>
 #include <string>
-#include "symbol.hpp"
 
 namespace AstlC {
 
-   class Scope {
-      private:
-	 typedef std::map<std::string, Symbol> SymMap;
-	 SymMap symbols;
-	 Scope* outer;
-
+   /* contiguous read-only view of an entire input
+      which is either memory-mapped from a file or
+      read completely into memory */
+   class SourceBuffer {
       public:
 	 // constructors
-	 Scope() : outer(nullptr) {
-	 }
-	 Scope(Scope* outer_param) : outer(outer_param) {
-	 }
+	 SourceBuffer(const std::string& filename); // memory-mapped
+	 SourceBuffer(std::istream& in); // read until eof
+	 SourceBuffer(std::string&& contents); // taken over
+	 SourceBuffer(const SourceBuffer&) = delete;
+	 SourceBuffer& operator=(const SourceBuffer&) = delete;
+	 ~SourceBuffer();
 
 	 // accessors
-	 bool lookup(const std::string& name, Symbol& symbol) const {
-	    auto it = symbols.find(name);
-	    if (it == symbols.end()) {
-	       if (outer) {
-		  return outer->lookup(name, symbol);
-	       } else {
-		  return false;
-	       }
-	    } else {
-	       symbol = it->second;
-	       return true;
-	    }
-	 }
+	 const char* begin() const;
+	 const char* end() const;
+	 std::size_t size() const;
 
-	 Scope* get_outer() const {
-	    return outer;
-	 }
-
-	 // mutators
-	 bool insert(const Symbol& symbol) {
-	    auto result =
-	       symbols.insert(SymMap::value_type(symbol.get_name(), symbol));
-	    return result.second;
-	 }
+      private:
+	 std::string contents; // unless memory-mapped
+	 void* mapped; // address of memory-mapped region, if any
+	 std::size_t mapped_size;
    };
 
 } // namespace AstlC
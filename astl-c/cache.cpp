@@ -0,0 +1,311 @@
+/*
+   Copyright (C) 2026 The Astl-C contributors
+   ----------------------------------------------------------------------------
+   Astl-C is free software; you can redistribute it
+   and/or modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either version
+   2 of the License, or (at your option) any later version.
+
+   Astl-C is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+
+#include <cerrno>
+#include <cstdlib>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <thread>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <astl/exception.hpp>
+#include "buffer.hpp"
+#include "cache.hpp"
+#include "hash.hpp"
+
+namespace AstlC {
+
+static const char* const magic = "astl-c cache 4";
+
+// private functions =========================================================
+
+/* returns a fingerprint of the given contents */
+static std::string get_fingerprint(const char* begin, const char* end) {
+   Hash hash;
+   hash.add(begin, end);
+   std::ostringstream os;
+   os << (end - begin) << ":" << hash.get_hex();
+   return os.str();
+}
+
+/* returns a fingerprint of the contents of the given file
+   or an empty string if the file cannot be read */
+static std::string get_fingerprint(const std::string& filename) {
+   try {
+      SourceBuffer contents(filename);
+      return get_fingerprint(contents.begin(), contents.end());
+   } catch (Astl::Exception&) {
+      return "";
+   }
+}
+
+/* returns the pathname under which execvp finds the given
+   program or the name itself if it cannot be found */
+static std::string find_program(const std::string& name) {
+   if (name.find('/') != std::string::npos) return name;
+   const char* path = std::getenv("PATH");
+   std::string dirs = path? path: "/bin:/usr/bin";
+   std::size_t pos = 0;
+   for(;;) {
+      std::size_t end = dirs.find(':', pos);
+      if (end == std::string::npos) end = dirs.size();
+      std::string dir = dirs.substr(pos, end - pos);
+      std::string pathname = (dir.size() > 0? dir: ".") + "/" + name;
+      if (access(pathname.c_str(), X_OK) == 0) return pathname;
+      if (end == dirs.size()) return name;
+      pos = end + 1;
+   }
+}
+
+/* returns a description of what beyond its arguments and the
+   files it reads may change the output of the preprocessor:
+   the environment variables considered by gcc -E and the
+   size and modification time of the preprocessor executable;
+   the built-in preprocessor is keyed as "cpp (builtin)" but
+   still depends on cpp for its configuration */
+static std::string get_environment(const std::string& cpp_path) {
+   std::ostringstream os;
+   for (auto name: {"CPATH", "C_INCLUDE_PATH", "GCC_EXEC_PREFIX"}) {
+      const char* value = std::getenv(name);
+      if (value) {
+	 os << name << "=" << value;
+      }
+      os << '\n';
+   }
+   std::string program = find_program(cpp_path.substr(0,
+      cpp_path.find(" (builtin)")));
+   struct stat statbuf;
+   os << program;
+   if (stat(program.c_str(), &statbuf) == 0) {
+      os << " " << statbuf.st_size << " " << statbuf.st_mtime;
+   }
+   return os.str();
+}
+
+/* collect all files named in the linemarkers of the
+   preprocessor output, excluding pseudo files like <built-in> */
+static std::set<std::string> get_dependencies(const char* begin,
+      const char* end) {
+   std::set<std::string> filenames;
+   const char* cp = begin;
+   while (cp < end) {
+      const char* eol = cp;
+      while (eol < end && *eol != '\n') ++eol;
+      /* linemarkers look like: # linenumber "filename" flags */
+      if (*cp == '#') {
+	 do {
+	    ++cp;
+	 } while (cp < eol && *cp == ' ');
+	 if (cp < eol && *cp >= '0' && *cp <= '9') {
+	    while (cp < eol && *cp != '"') ++cp;
+	    if (cp < eol) {
+	       std::string filename;
+	       ++cp;
+	       while (cp < eol && *cp != '"') {
+		  if (*cp == '\\' && cp + 1 < eol) ++cp;
+		  filename += *cp++;
+	       }
+	       if (filename.size() > 0 && filename[0] != '<') {
+		  filenames.insert(filename);
+	       }
+	    }
+	 }
+      }
+      cp = eol + 1;
+   }
+   return filenames;
+}
+
+static void write_string(std::ostream& out, const std::string& s) {
+   out << s.size() << '\n' << s << '\n';
+}
+
+static bool read_string(std::istream& in, std::string& s) {
+   std::size_t len;
+   if (!(in >> len) || in.get() != '\n') return false;
+   s.resize(len);
+   if (len > 0 && !in.read(&s[0], len)) return false;
+   return in.get() == '\n';
+}
+
+static bool read_count(std::istream& in, std::size_t& count) {
+   return (in >> count) && in.get() == '\n';
+}
+
+/* write to a temporary file first and rename it afterwards
+   such that concurrent readers never see an incomplete entry;
+   failures are silently ignored as caching is optional */
+static void write_entry(const std::string& path,
+      const std::string& contents) {
+   std::ostringstream tmpname;
+   tmpname << path << ".tmp." << getpid() << "." <<
+      std::this_thread::get_id();
+   std::string tmppath = tmpname.str();
+   {
+      std::ofstream out(tmppath, std::ios::binary);
+      if (!out) return;
+      out << contents;
+      if (!out) {
+	 out.close();
+	 unlink(tmppath.c_str());
+	 return;
+      }
+   }
+   if (rename(tmppath.c_str(), path.c_str()) < 0) {
+      unlink(tmppath.c_str());
+   }
+}
+
+// constructor ===============================================================
+
+CacheEntry::CacheEntry(const std::string& dir, const std::string& kind,
+      const std::string& cpp_path, const Args& args,
+      const std::string& input_file) :
+      kind(kind), cpp_path(cpp_path), args(args), input_file(input_file),
+      fingerprint(get_fingerprint(input_file)),
+      environment(get_environment(cpp_path)) {
+   Hash key;
+   key.add(kind);
+   key.add(cpp_path);
+   key.add(environment);
+   for (auto& arg: args) {
+      key.add(arg);
+   }
+   key.add(input_file);
+   key.add(fingerprint);
+   path = dir + "/" + key.get_hex();
+}
+
+// accessors =================================================================
+
+bool CacheEntry::cacheable() const {
+   return fingerprint.size() > 0;
+}
+
+bool CacheEntry::load(std::string& data) const {
+   if (!cacheable()) return false;
+   std::ifstream in(path, std::ios::binary);
+   if (!in) return false;
+   std::string line;
+   if (!std::getline(in, line) || line != magic) return false;
+   /* the key is verified in full to protect against hash collisions */
+   std::string s;
+   if (!read_string(in, s) || s != kind) return false;
+   if (!read_string(in, s) || s != cpp_path) return false;
+   if (!read_string(in, s) || s != environment) return false;
+   std::size_t nargs;
+   if (!read_count(in, nargs) || nargs != args.size()) return false;
+   for (auto& arg: args) {
+      if (!read_string(in, s) || s != arg) return false;
+   }
+   if (!read_string(in, s) || s != input_file) return false;
+   if (!read_string(in, s) || s != fingerprint) return false;
+   /* check that none of the included files has been changed */
+   std::size_t ndeps;
+   if (!read_count(in, ndeps)) return false;
+   for (std::size_t i = 0; i < ndeps; ++i) {
+      std::string filename, fp;
+      if (!read_string(in, filename) || !read_string(in, fp)) return false;
+      if (get_fingerprint(filename) != fp) return false;
+   }
+   return read_string(in, data);
+}
+
+void CacheEntry::store(const char* output_begin, const char* output_end,
+      const std::string& data) const {
+   if (!cacheable()) return;
+   std::vector<std::pair<std::string, std::string>> dependencies;
+   for (auto& filename: get_dependencies(output_begin, output_end)) {
+      std::string fp = get_fingerprint(filename);
+      if (fp.size() == 0) return; // we could not validate it later
+      dependencies.push_back(std::make_pair(filename, fp));
+   }
+   std::ostringstream out;
+   out << magic << '\n';
+   write_string(out, kind);
+   write_string(out, cpp_path);
+   write_string(out, environment);
+   out << args.size() << '\n';
+   for (auto& arg: args) {
+      write_string(out, arg);
+   }
+   write_string(out, input_file);
+   write_string(out, fingerprint);
+   out << dependencies.size() << '\n';
+   for (auto& dependency: dependencies) {
+      write_string(out, dependency.first);
+      write_string(out, dependency.second);
+   }
+   write_string(out, data);
+   write_entry(path, out.str());
+}
+
+// constructor ===============================================================
+
+OutputCacheEntry::OutputCacheEntry(const std::string& dir,
+      const std::string& kind, const std::string& input_file,
+      const char* output_begin, const char* output_end) :
+      kind(kind), input_file(input_file) {
+   /* the output is not stored, hence a strong digest is needed */
+   Digest output_digest;
+   output_digest.add(output_begin, output_end);
+   digest = output_digest.get_hex();
+   Hash key;
+   key.add(kind);
+   key.add(input_file);
+   key.add(digest);
+   path = dir + "/" + key.get_hex();
+}
+
+// accessors =================================================================
+
+bool OutputCacheEntry::load(std::string& data) const {
+   std::ifstream in(path, std::ios::binary);
+   if (!in) return false;
+   std::string line;
+   if (!std::getline(in, line) || line != magic) return false;
+   std::string s;
+   if (!read_string(in, s) || s != kind) return false;
+   if (!read_string(in, s) || s != input_file) return false;
+   if (!read_string(in, s) || s != digest) return false;
+   return read_string(in, data);
+}
+
+void OutputCacheEntry::store(const std::string& data) const {
+   std::ostringstream out;
+   out << magic << '\n';
+   write_string(out, kind);
+   write_string(out, input_file);
+   write_string(out, digest);
+   write_string(out, data);
+   write_entry(path, out.str());
+}
+
+// functions =================================================================
+
+void create_cache_dir(const std::string& dir) {
+   if (mkdir(dir.c_str(), 0777) < 0 && errno != EEXIST) {
+      std::ostringstream os;
+      os << "unable to create cache directory " << dir;
+      throw Astl::Exception(os.str());
+   }
+}
+
+} // namespace AstlC
@@ -0,0 +1,95 @@
+/*
+   Copyright (C) 2026 The Astl-C contributors
+   ----------------------------------------------------------------------------
+   Astl-C is free software; you can redistribute it
+   and/or modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either version
+   2 of the License, or (at your option) any later version.
+
+   Astl-C is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+
+#ifndef ASTL_C_CACHE_H
+#define ASTL_C_CACHE_H
+
+#include <string>
+#include <vector>
+#include "pp.hpp"
+
+namespace AstlC {
+
+   /* entry of an on-disk cache which holds data derived from
+      the preprocessed output of a source;
+      an entry is identified by its kind, the preprocessor path,
+      its arguments, its environment, the name of the source, and
+      the contents of the source; it is valid as long as none of the files named
+      in the linemarkers of the preprocessed output has been
+      changed since */
+   class CacheEntry {
+      public:
+	 // constructor
+	 CacheEntry(const std::string& dir, const std::string& kind,
+	    const std::string& cpp_path, const Args& args,
+	    const std::string& input_file);
+
+	 // accessors
+	 /* false if the source cannot be read */
+	 bool cacheable() const;
+	 /* fetch the cached data if the entry exists and is valid */
+	 bool load(std::string& data) const;
+	 /* store data that has been derived from the given
+	    preprocessor output; failures are silently ignored
+	    as caching is optional */
+	 void store(const char* output_begin, const char* output_end,
+	    const std::string& data) const;
+
+      private:
+	 std::string path;
+	 std::string kind;
+	 std::string cpp_path;
+	 Args args;
+	 std::string input_file;
+	 std::string fingerprint; // of the source
+	 std::string environment; // of the preprocessor
+   };
+
+   /* entry of an on-disk cache which holds data derived from
+      the preprocessed output of a source;
+      an entry is identified by its kind, the name of the source,
+      and the SHA-256 digest of the preprocessed output; unlike
+      CacheEntry, it does not depend on any files and remains
+      valid as long as the same output is delivered */
+   class OutputCacheEntry {
+      public:
+	 // constructor
+	 OutputCacheEntry(const std::string& dir, const std::string& kind,
+	    const std::string& input_file,
+	    const char* output_begin, const char* output_end);
+
+	 // accessors
+	 /* fetch the cached data if the entry exists */
+	 bool load(std::string& data) const;
+	 /* store data; failures are silently ignored */
+	 void store(const std::string& data) const;
+
+      private:
+	 std::string path;
+	 std::string kind;
+	 std::string input_file;
+	 std::string digest; // of the preprocessed output
+   };
+
+   /* create the cache directory unless it exists already */
+   void create_cache_dir(const std::string& dir);
+
+} // namespace AstlC
+
+#endif
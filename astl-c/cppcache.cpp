@@ -0,0 +1,49 @@
+/*
+   Copyright (C) 2026 The Astl-C contributors
+   ----------------------------------------------------------------------------
+   Astl-C is free software; you can redistribute it
+   and/or modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either version
+   2 of the License, or (at your option) any later version.
+
+   Astl-C is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+
+#include "cache.hpp"
+#include "cppcache.hpp"
+
+namespace AstlC {
+
+// constructor ===============================================================
+
+CppCache::CppCache(const std::string& dir) : dir(dir) {
+   create_cache_dir(dir);
+}
+
+// accessor ==================================================================
+
+std::string CppCache::preprocess(const std::string& cpp_path,
+      const Args& args, const std::string& input_file,
+      bool& success, double* cpu_time) const {
+   CacheEntry entry(dir, "cpp", cpp_path, args, input_file);
+   std::string output;
+   if (cpu_time) *cpu_time = 0;
+   success = true;
+   if (entry.load(output)) return output;
+   output = AstlC::preprocess(cpp_path, args, input_file, success,
+      cpu_time);
+   if (success) {
+      entry.store(output.data(), output.data() + output.size(), output);
+   }
+   return output;
+}
+
+} // namespace AstlC
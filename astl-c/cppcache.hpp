@@ -0,0 +1,52 @@
+/*
+   Copyright (C) 2026 The Astl-C contributors
+   ----------------------------------------------------------------------------
+   Astl-C is free software; you can redistribute it
+   and/or modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either version
+   2 of the License, or (at your option) any later version.
+
+   Astl-C is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+
+#ifndef ASTL_C_CPPCACHE_H
+#define ASTL_C_CPPCACHE_H
+
+#include <string>
+#include "pp.hpp"
+
+namespace AstlC {
+
+   /* on-disk cache of preprocessor outputs, see CacheEntry */
+   class CppCache {
+      public:
+	 // constructor
+	 CppCache(const std::string& dir);
+
+	 // accessor
+	 /* returns the output of the preprocessor, either from the
+	    cache or by running the preprocessor and storing the output
+	    in the cache if the preprocessor succeeded;
+	    success is set to false if the preprocessor failed;
+	    the CPU time of the preprocessor, 0 if the output was
+	    taken from the cache, is stored in cpu_time if given;
+	    this may be invoked by multiple threads in parallel */
+	 std::string preprocess(const std::string& cpp_path,
+	    const Args& args, const std::string& input_file,
+	    bool& success, double* cpu_time = nullptr) const;
+
+      private:
+	 std::string dir;
+   };
+
+} // namespace AstlC
+
+#endif
@@ -0,0 +1,38 @@
+/*
+   Copyright (C) 2026 The Astl-C contributors
+   ----------------------------------------------------------------------------
+   Astl-C is free software; you can redistribute it
+   and/or modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either version
+   2 of the License, or (at your option) any later version.
+
+   Astl-C is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+#include <mutex>
+#include <unordered_set>
+#include "filenames.hpp"
+
+namespace AstlC {
+
+/* elements of an unordered set do not move on rehashing */
+static std::mutex mutex;
+static std::unordered_set<std::string> filenames;
+
+const std::string* intern_filename(const std::string& filename) {
+   std::lock_guard<std::mutex> lock(mutex);
+   return &*filenames.insert(filename).first;
+}
+
+const std::string* intern_filename(const char* begin, const char* end) {
+   return intern_filename(std::string(begin, end));
+}
+
+} // namespace AstlC
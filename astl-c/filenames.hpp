@@ -0,0 +1,36 @@
+/*
+   Copyright (C) 2026 The Astl-C contributors
+   ----------------------------------------------------------------------------
+   Astl-C is free software; you can redistribute it
+   and/or modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either version
+   2 of the License, or (at your option) any later version.
+
+   Astl-C is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+#ifndef ASTL_C_FILENAMES_H
+#define ASTL_C_FILENAMES_H
+
+#include <cstddef>
+#include <string>
+
+namespace AstlC {
+
+   /* return the process-wide copy of the given filename;
+      locations refer to filenames by pointer, hence the copies
+      are kept until the end of the program and equal filenames
+      are represented by the same pointer */
+   const std::string* intern_filename(const std::string& filename);
+   const std::string* intern_filename(const char* begin, const char* end);
+
+} // namespace AstlC
+
+#endif
@@ -0,0 +1,198 @@
+#!/usr/bin/env perl
+#
+#   Copyright (C) 2026 The Astl-C contributors
+#   ----------------------------------------------------------------------------
+#   Astl-C is free software; you can redistribute it
+#   and/or modify it under the terms of the GNU Library General Public
+#   License as published by the Free Software Foundation; either version
+#   2 of the License, or (at your option) any later version.
+#
+#   Astl-C is distributed in the hope that it will be
+#   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+#   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+#   Library General Public License for more details.
+#
+#   You should have received a copy of the GNU Library General Public
+#   License along with this library; if not, write to the Free Software
+#   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+#
+# Generate synthetic preprocessed C sources for benchmarking
+# the scanner and the parser of astl-c.
+#
+# Usage: gencorpus.pl [-size kbytes] [-depth n] [-seed n] shape
+#
+# shapes:
+#    nesting        deeply nested statements and parenthesized expressions
+#    expressions    long expressions with all kinds of operators
+#    initializers   huge initializer lists
+#    typedefs       many typedefs which are used and shadowed in blocks
+#    linemarkers    declarations interspersed with linemarkers
+#    mixed          all of the above in turn
+
+use strict;
+use warnings;
+
+my $size = 1024; # approximate size of the output in kbytes
+my $depth = 100; # nesting depth for the nesting shape
+my $seed = 1;
+while (@ARGV && $ARGV[0] =~ /^-/) {
+   my $opt = shift;
+   die "argument for $opt is missing\n" unless @ARGV;
+   my $val = shift;
+   die "invalid argument for $opt\n" unless $val =~ /^\d+$/ && $val > 0;
+   if ($opt eq "-size") {
+      $size = $val;
+   } elsif ($opt eq "-depth") {
+      $depth = $val;
+   } elsif ($opt eq "-seed") {
+      $seed = $val;
+   } else {
+      die "unknown option $opt\n";
+   }
+}
+die "Usage: $0 [-size kbytes] [-depth n] [-seed n] shape\n"
+   unless @ARGV == 1;
+my $shape = shift;
+srand($seed);
+
+my %generators = (
+   nesting => \&gen_nesting,
+   expressions => \&gen_expressions,
+   initializers => \&gen_initializers,
+   typedefs => \&gen_typedefs,
+   linemarkers => \&gen_linemarkers,
+);
+my @shapes;
+if ($shape eq "mixed") {
+   @shapes = sort keys %generators;
+} elsif ($generators{$shape}) {
+   @shapes = ($shape);
+} else {
+   die "unknown shape $shape\n";
+}
+
+my $count = 0; # for unique names
+my $bytes = 0;
+emit("# 1 \"$shape.c\"\n");
+while ($bytes < $size * 1024) {
+   for my $s (@shapes) {
+      $generators{$s}->();
+   }
+}
+
+sub emit {
+   my $text = join("", @_);
+   $bytes += length($text);
+   print $text;
+}
+
+sub operand {
+   my @operands = ("a", "b", "c", "p->x", "q[i]", "f(a, b)", "42",
+      "0x7fU", "3.5e2", "'c'", "sizeof(int)", "(long) b");
+   return $operands[int(rand(@operands))];
+}
+
+sub expression {
+   my ($length) = @_;
+   my @ops = ("+", "-", "*", "/", "%", "<<", ">>", "&", "|", "^",
+      "&&", "||", "<", "<=", "==", "!=");
+   my $expr = operand();
+   for (my $i = 1; $i < $length; ++$i) {
+      my $op = $ops[int(rand(@ops))];
+      if (rand() < 0.2) {
+	 $expr = "($expr) $op " . operand();
+      } elsif (rand() < 0.1) {
+	 $expr = "$expr $op (a ? b : c)";
+      } else {
+	 $expr = "$expr $op " . operand();
+      }
+   }
+   return $expr;
+}
+
+sub function_header {
+   my $name = "f" . $count++;
+   return "int $name(int a, int b, int c, " .
+      "struct s { int x; } *p, int *q, int i) {\n";
+}
+
+sub gen_nesting {
+   my $text = function_header();
+   my $indent = "   ";
+   for (my $i = 0; $i < $depth; ++$i) {
+      my $kind = $i % 4;
+      if ($kind == 0) {
+	 $text .= $indent . "if (" . ("(" x 8) . "a" .
+	    (" + b)" x 8) . ") {\n";
+      } elsif ($kind == 1) {
+	 $text .= $indent . "while (a < b) {\n";
+      } elsif ($kind == 2) {
+	 $text .= $indent . "for (i = 0; i < c; ++i) {\n";
+      } else {
+	 $text .= $indent . "switch (a) { case 1: {\n";
+      }
+      $text .= $indent . "   int v$i = a;\n";
+   }
+   $text .= $indent . "a = " . expression(5) . ";\n";
+   for (my $i = $depth - 1; $i >= 0; --$i) {
+      $text .= $indent . (($i % 4 == 3)? "} }\n": "}\n");
+   }
+   $text .= "   return a;\n}\n";
+   emit($text);
+}
+
+sub gen_expressions {
+   my $text = function_header();
+   for (my $i = 0; $i < 20; ++$i) {
+      $text .= "   a = " . expression(200) . ";\n";
+   }
+   $text .= "   return a;\n}\n";
+   emit($text);
+}
+
+sub gen_initializers {
+   my $name = "table" . $count++;
+   my $text = "static const struct { int key; double val; " .
+      "const char* name; } ${name}[] = {\n";
+   for (my $i = 0; $i < 5000; ++$i) {
+      if ($i % 3 == 0) {
+	 $text .= "   [$i] = { .key = $i, .val = $i.5, " .
+	    ".name = \"entry\" \"$i\" },\n";
+      } else {
+	 $text .= "   { $i, -$i.25e-3, \"e$i\" },\n";
+      }
+   }
+   $text .= "};\n";
+   emit($text);
+}
+
+sub gen_typedefs {
+   my $text = "";
+   my $base = $count++;
+   for (my $i = 0; $i < 200; ++$i) {
+      $text .= "typedef unsigned long T${base}_$i;\n";
+   }
+   $text .= "int g$base(void) {\n";
+   for (my $i = 0; $i < 200; ++$i) {
+      $text .= "   T${base}_$i x$i = (T${base}_$i) $i;\n";
+      if ($i % 10 == 0) {
+	 # shadow the typedef name by a variable in an inner block
+	 $text .= "   { int T${base}_$i = x$i; T${base}_$i += 1; }\n";
+      }
+   }
+   $text .= "   return 0;\n}\n";
+   emit($text);
+}
+
+sub gen_linemarkers {
+   my $text = "";
+   for (my $i = 0; $i < 200; ++$i) {
+      my $file = "/usr/include/header" . ($i % 20) . ".h";
+      $text .= "# " . ($i * 10 + 1) . " \"$file\" 1 3 4\n";
+      $text .= "extern int v" . $count++ . ";\n";
+      $text .= "# " . ($i * 10 + 5) . " \"$file\"\n";
+      $text .= "extern long w" . $count++ . "(int, char*);\n";
+      $text .= "# " . ($i + 1) . " \"$shape.c\" 2\n";
+   }
+   emit($text);
+}
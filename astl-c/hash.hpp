@@ -0,0 +1,94 @@
+/*
+   Copyright (C) 2026 The Astl-C contributors
+   ----------------------------------------------------------------------------
+   Astl-C is free software; you can redistribute it
+   and/or modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either version
+   2 of the License, or (at your option) any later version.
+
+   Astl-C is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+
+#ifndef ASTL_C_HASH_H
+#define ASTL_C_HASH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+namespace AstlC {
+
+   /* 64-bit FNV-1a hash which is used to detect changes
+      of sources and of cached contents;
+      it is not suitable for any cryptographic purposes */
+   class Hash {
+      public:
+	 // constructor
+	 Hash() : value(0xcbf29ce484222325) {
+	 }
+
+	 // accessors
+	 std::uint64_t get_value() const {
+	    return value;
+	 }
+	 std::string get_hex() const {
+	    std::ostringstream os;
+	    os << std::hex << std::setw(16) << std::setfill('0') << value;
+	    return os.str();
+	 }
+
+	 // mutators
+	 void add(const char* begin, const char* end) {
+	    for (const char* cp = begin; cp != end; ++cp) {
+	       value ^= static_cast<unsigned char>(*cp);
+	       value *= 0x100000001b3;
+	    }
+	 }
+	 void add(const std::string& s) {
+	    add(s.data(), s.data() + s.size());
+	    /* include the terminator such that the hash of a
+	       sequence of strings depends on their boundaries */
+	    char terminator = 0;
+	    add(&terminator, &terminator + 1);
+	 }
+
+      private:
+	 std::uint64_t value;
+   };
+
+   /* SHA-256 digest which is used where a collision
+      must not go unnoticed, i.e. if the contents
+      are not compared in full */
+   class Digest {
+      public:
+	 // constructor
+	 Digest();
+
+	 // accessor
+	 std::string get_hex() const;
+
+	 // mutator
+	 void add(const char* begin, const char* end);
+
+      private:
+	 std::uint32_t state[8];
+	 unsigned char block[64];
+	 std::size_t blocklen; // number of bytes in block
+	 std::uint64_t length; // total number of bytes added
+
+	 void process_block();
+   };
+
+} // namespace AstlC
+
+#endif
@@ -16,6 +16,8 @@
    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
 */
 
+#include <algorithm>
+#include <cstring>
 #include "scanner.hpp"
 #include "parser.hpp"
 #include "keywords.hpp"
@@ -94,20 +96,62 @@ static struct {
    {"__volatile__", parser::token::VOLATILE},
 };
 
-KeywordTable::KeywordTable() {
-   for (std::size_t i = 0; i < sizeof(keywords)/sizeof(keywords[0]); ++i) {
-      tab[keywords[i].keyword] = keywords[i].token;
+static constexpr std::size_t number_of_keywords =
+   sizeof(keywords)/sizeof(keywords[0]);
+
+// constructor ===============================================================
+
+/* search for a seed for which no two keywords share a slot;
+   with less than 1/6 of the slots in use, this takes
+   typically just a few dozen attempts */
+KeywordTable::KeywordTable() : seed(0) {
+   static_assert(number_of_keywords < 256,
+      "keyword indices must fit into the slots");
+   for (;;) {
+      ++seed;
+      std::fill(slots, slots + table_size, 0);
+      bool collision = false;
+      for (std::size_t i = 0; i < number_of_keywords; ++i) {
+	 const char* keyword = keywords[i].keyword;
+	 std::size_t slot = hash(keyword, keyword + std::strlen(keyword));
+	 if (slots[slot]) {
+	    collision = true; break;
+	 }
+	 slots[slot] = i + 1;
+      }
+      if (!collision) break;
    }
 }
 
+// accessors =================================================================
+
 bool KeywordTable::lookup(const std::string& ident, int& token) const {
-   std::map<std::string, int>::const_iterator it = tab.find(ident);
-   if (it == tab.end()) {
+   return lookup(ident.data(), ident.data() + ident.size(), token);
+}
+
+bool KeywordTable::lookup(const char* begin, const char* end,
+      int& token) const {
+   unsigned int index = slots[hash(begin, end)];
+   if (index == 0) return false;
+   const char* keyword = keywords[index - 1].keyword;
+   std::size_t len = end - begin;
+   if (std::strncmp(keyword, begin, len) != 0 || keyword[len] != 0) {
       return false;
-   } else {
-      token = it->second;
-      return true;
    }
+   token = keywords[index - 1].token;
+   return true;
+}
+
+// private accessor ==========================================================
+
+std::size_t KeywordTable::hash(const char* begin, const char* end) const {
+   std::uint32_t value = 2166136261u ^ seed;
+   for (const char* cp = begin; cp != end; ++cp) {
+      value ^= static_cast<unsigned char>(*cp);
+      value *= 16777619u;
+   }
+   value ^= value >> 15;
+   return value & (table_size - 1);
 }
 
 KeywordTable keyword_table;
@@ -19,21 +19,30 @@
 #ifndef ASTL_C_KEYWORDS_H
 #define ASTL_C_KEYWORDS_H
 
-#include <map>
+#include <cstddef>
+#include <cstdint>
 #include <string>
 
 namespace AstlC {
 
+   /* perfect hash table of all keywords which is
+      computed once from the keyword list on startup */
    class KeywordTable {
       public:
 	 // constructor
 	 KeywordTable();
 
-	 // accessor
+	 // accessors
 	 bool lookup(const std::string& ident, int& token) const;
+	 bool lookup(const char* begin, const char* end, int& token) const;
 
       private:
-	 std::map<std::string, int> tab;
+	 static constexpr std::size_t table_size = 512;
+	 std::uint32_t seed;
+	 /* index + 1 into the keyword list, 0 for empty slots */
+	 unsigned char slots[table_size];
+
+	 std::size_t hash(const char* begin, const char* end) const;
    };
 
    extern KeywordTable keyword_table;
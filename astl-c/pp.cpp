@@ -17,52 +17,196 @@
 */
 
 
+#include <cerrno>
 #include <cstdlib>
+#include <sstream>
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
 #include <unistd.h>
 #include <astl/exception.hpp>
 #include <boost/version.hpp>
+#include "cppcache.hpp"
 #include "pp.hpp"
 
 namespace AstlC {
 
+/* start the preprocessor and return the reading end of a pipe
+   that is connected to its standard output or, if diagnostics
+   is set, to its standard error while its standard output is
+   discarded */
 static int create_pipe(const std::string& cpp_path,
-      const Args& args, const std::string& input_file) {
+      const Args& args, const std::string& input_file, pid_t& pid,
+      bool diagnostics = false) {
+   /* the argument vector is prepared in advance as the child
+      must not allocate memory if other threads are running */
+   std::vector<const char*> argv;
+   argv.push_back(cpp_path.c_str());
+   argv.push_back("-E");
+   for (std::size_t i = 0; i < args.size(); ++i) {
+      argv.push_back(args[i].c_str());
+   }
+   argv.push_back(input_file.c_str());
+   argv.push_back(nullptr);
+
+   /* the pipe is created close-on-exec in one step to make sure
+      that preprocessors started in parallel by other threads
+      do not inherit the pipes of each other */
    int fds[2];
-   if (pipe(fds) < 0) {
+   if (pipe2(fds, O_CLOEXEC) < 0) {
       throw Astl::Exception("unable to create a pipe");
    }
-   pid_t pid = fork();
+   pid = fork();
    if (pid < 0) {
+      close(fds[0]); close(fds[1]);
       throw Astl::Exception("unable to fork");
    }
    if (pid == 0) {
       close(fds[0]);
-      dup2(fds[1], 1);
-      close(fds[1]);
-      int argc = 4 + args.size();
-      const char** argv = new const char*[argc];
-      int argi = 0;
-      argv[argi++] = cpp_path.c_str();
-      argv[argi++] = "-E";
-      for (std::size_t i = 0; i < args.size(); ++i) {
-	 argv[argi++] = args[i].c_str();
+      if (diagnostics) {
+	 int fd = open("/dev/null", O_WRONLY);
+	 if (fd >= 0) {
+	    dup2(fd, 1); close(fd);
+	 }
+	 dup2(fds[1], 2);
+      } else {
+	 dup2(fds[1], 1);
       }
-      argv[argi++] = input_file.c_str();
-      argv[argi++] = 0;
-      execvp(argv[0], (char* const*) argv);
-      exit(255);
+      close(fds[1]);
+      execvp(argv[0], (char* const*) &argv[0]);
+      _exit(255);
    }
    close(fds[1]);
    return fds[0];
 }
 
+/* wait for the preprocessor process to finish and return its
+   CPU time; success is set to false if it failed */
+static double reap(pid_t pid, bool& success) {
+   int status;
+   struct rusage usage;
+   pid_t result;
+   while ((result = wait4(pid, &status, 0, &usage)) < 0 && errno == EINTR);
+   success = result == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+   if (result != pid) return 0;
+   return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6 +
+      usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+}
+
+/* read everything from fd and reap the preprocessor process */
+static std::string slurp(int fd, pid_t pid, bool& success,
+      double* cpu_time = nullptr) {
+   std::string output;
+   char buf[65536];
+   for(;;) {
+      ssize_t nbytes = read(fd, buf, sizeof buf);
+      if (nbytes < 0 && errno == EINTR) continue;
+      if (nbytes <= 0) break;
+      output.append(buf, nbytes);
+   }
+   close(fd);
+   double time = reap(pid, success);
+   if (cpu_time) *cpu_time = time;
+   return output;
+}
+
+std::string preprocess(const std::string& cpp_path,
+      const Args& args, const std::string& input_file, bool& success,
+      double* cpu_time) {
+   pid_t pid;
+   int fd = create_pipe(cpp_path, args, input_file, pid);
+   return slurp(fd, pid, success, cpu_time);
+}
+
+std::string query_preprocessor(const std::string& cpp_path,
+      const Args& args, bool diagnostics) {
+   Args query_args(args);
+   query_args.push_back("-x");
+   query_args.push_back("c");
+   pid_t pid;
+   int fd = create_pipe(cpp_path, query_args, "/dev/null", pid, diagnostics);
+   bool success;
+   std::string output = slurp(fd, pid, success);
+   if (!success && !diagnostics) {
+      std::ostringstream os;
+      os << "unable to query the preprocessor " << cpp_path;
+      throw Astl::Exception(os.str());
+   }
+   return output;
+}
+
 cpp_istream::cpp_istream(const std::string& cpp_path,
       const Args& args, const std::string& input_file) :
-   fdistream(create_pipe(cpp_path, args, input_file)
+   fdistream(create_pipe(cpp_path, args, input_file, pid)
 #if BOOST_VERSION >= 104601
       , boost::iostreams::close_handle
 #endif
       ) {
 }
 
+/* the pipe is closed first as the preprocessor
+   may be still waiting to write the rest of its output */
+cpp_istream::~cpp_istream() {
+   finish();
+}
+
+double cpp_istream::finish() {
+   if (is_open()) close();
+   if (pid == 0) return 0;
+   bool success;
+   double cpu_time = reap(pid, success);
+   pid = 0;
+   return cpu_time;
+}
+
+cpp_prefetcher::cpp_prefetcher(const std::string& cpp_path,
+      unsigned int depth, const CppCache* cache) :
+   cpp_path(cpp_path), depth(depth > 0? depth: 1), cache(cache),
+   launched(0), fetched(0) {
+}
+
+void cpp_prefetcher::add(const Args& args, const std::string& input_file) {
+   jobs.push_back(Job{args, input_file, std::future<Output>()});
+}
+
+std::string cpp_prefetcher::next(bool& success, double* cpu_time) {
+   if (fetched >= jobs.size()) {
+      throw Astl::Exception("no more sources to be preprocessed");
+   }
+   /* keep the pipeline filled such that depth preprocessors
+      run ahead while the consumer works on this output */
+   while (launched < jobs.size() && launched < fetched + 1 + depth) {
+      launch();
+   }
+   Output output = jobs[fetched].output.get();
+   ++fetched;
+   success = output.success;
+   if (cpu_time) *cpu_time = output.cpu_time;
+   return std::move(output.text);
+}
+
+void cpp_prefetcher::launch() {
+   Job& job = jobs[launched];
+   if (cache) {
+      job.output = std::async(std::launch::async,
+	 [this, args = job.args, input_file = job.input_file]() {
+	    Output output;
+	    output.text = cache->preprocess(cpp_path, args, input_file,
+	       output.success, &output.cpu_time);
+	    return output;
+	 });
+      ++launched;
+      return;
+   }
+   pid_t pid;
+   int fd = create_pipe(cpp_path, job.args, job.input_file, pid);
+   job.output = std::async(std::launch::async,
+      [fd, pid]() {
+	 Output output;
+	 output.text = slurp(fd, pid, output.success, &output.cpu_time);
+	 return output;
+      });
+   ++launched;
+}
+
 } // namespace AstlC
@@ -19,6 +19,9 @@
 #ifndef ASTL_C_PP_H
 #define ASTL_C_PP_H
 
+#include <sys/types.h>
+#include <cstddef>
+#include <future>
 #include <iostream>
 #include <string>
 #include <vector>
@@ -32,10 +35,73 @@ namespace AstlC {
    typedef boost::iostreams::stream<boost::iostreams::file_descriptor_source>
       fdistream;
 
+   class CppCache;
+
+   /* run the preprocessor and return its entire output;
+      success is set to false if the preprocessor failed;
+      the CPU time of the preprocessor is stored in cpu_time
+      if given */
+   std::string preprocess(const std::string& cpp_path,
+      const Args& args, const std::string& input_file, bool& success,
+      double* cpu_time = nullptr);
+
+   /* run the preprocessor with the given options on an empty
+      C source and return what it writes on its standard output
+      or, if diagnostics is set, on its standard error */
+   std::string query_preprocessor(const std::string& cpp_path,
+      const Args& args, bool diagnostics = false);
+
    class cpp_istream: public fdistream {
       public:
 	 cpp_istream(const std::string& cpp_path,
 	    const Args& args, const std::string& input_file);
+	 ~cpp_istream();
+
+	 // mutator
+	 /* close the pipe, wait for the preprocessor to finish,
+	    and return its CPU time */
+	 double finish();
+
+      private:
+	 pid_t pid; // of the preprocessor, 0 once it has finished
+   };
+
+   /* runs the preprocessor for a sequence of sources ahead of time:
+      up to depth preprocessor processes are kept running in
+      parallel to the consumer and their output is buffered
+      in memory until it is fetched in the order of add();
+      the preprocessor is not invoked for sources found in the cache */
+   class cpp_prefetcher {
+      public:
+	 cpp_prefetcher(const std::string& cpp_path, unsigned int depth,
+	    const CppCache* cache = nullptr);
+
+	 // mutators
+	 void add(const Args& args, const std::string& input_file);
+	 /* output of the next source; success is set to false
+	    if its preprocessor failed; the CPU time of its
+	    preprocessor is stored in cpu_time if given */
+	 std::string next(bool& success, double* cpu_time = nullptr);
+
+      private:
+	 struct Output {
+	    std::string text;
+	    bool success;
+	    double cpu_time;
+	 };
+	 struct Job {
+	    Args args;
+	    std::string input_file;
+	    std::future<Output> output;
+	 };
+	 std::string cpp_path;
+	 unsigned int depth;
+	 const CppCache* cache;
+	 std::vector<Job> jobs;
+	 std::size_t launched; // number of jobs started so far
+	 std::size_t fetched; // number of jobs returned by next()
+
+	 void launch();
    };
 
 } // namespace AstlC
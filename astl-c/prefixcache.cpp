@@ -0,0 +1,141 @@
+/*
+   Copyright (C) 2026 The Astl-C contributors
+   ----------------------------------------------------------------------------
+   Astl-C is free software; you can redistribute it
+   and/or modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either version
+   2 of the License, or (at your option) any later version.
+
+   Astl-C is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+#include <cstring>
+#include "hash.hpp"
+#include "prefixcache.hpp"
+
+namespace AstlC {
+
+/* returns true if [cp, eol) is a linemarker
+   like # linenumber "filename" flags */
+static bool is_linemarker(const char* cp, const char* eol,
+      const char*& filename, std::size_t& len) {
+   if (cp == eol || *cp++ != '#') return false;
+   while (cp < eol && (*cp == ' ' || *cp == '\t')) ++cp;
+   if (cp == eol || *cp < '0' || *cp > '9') return false;
+   while (cp < eol && *cp >= '0' && *cp <= '9') ++cp;
+   while (cp < eol && (*cp == ' ' || *cp == '\t')) ++cp;
+   if (cp == eol || *cp++ != '"') return false;
+   filename = cp;
+   while (cp < eol && *cp != '"') {
+      if (*cp == '\\' && cp + 1 < eol) ++cp;
+      ++cp;
+   }
+   if (cp == eol) return false;
+   len = cp - filename;
+   return true;
+}
+
+// constructor ===============================================================
+
+PrefixCache::PrefixCache() {
+}
+
+// accessors =================================================================
+
+std::vector<PrefixCache::Cut> PrefixCache::get_cuts(const char* begin,
+      const char* end, const std::string& source_name) {
+   std::vector<Cut> cuts;
+   Hash hash;
+   std::size_t length = 0; // of the text covered by the hash
+   const char* chunk = begin; // beginning of the current chunk
+   bool main = false; // current chunk belongs to the main source
+   /* the parser is between two external declarations
+      if all brackets are closed and the last token was a semicolon */
+   int depth = 0;
+   bool between = true;
+   bool comment = false; // within a comment, if -C was given
+   for (const char* cp = begin; cp < end;) {
+      const char* eol = static_cast<const char*>(
+	 std::memchr(cp, '\n', end - cp));
+      eol = eol? eol + 1: end;
+      const char* line = cp;
+      while (cp < eol && (*cp == ' ' || *cp == '\t')) ++cp;
+      if (!comment && cp < eol && *cp == '#') {
+	 /* directives are ignored by the scanner
+	    but linemarkers separate the chunks */
+	 const char* filename; std::size_t len;
+	 if (is_linemarker(cp, eol, filename, len)) {
+	    if (!main) {
+	       hash.add(chunk, line);
+	       char terminator = 0;
+	       hash.add(&terminator, &terminator + 1);
+	       length += line - chunk;
+	    }
+	    chunk = line;
+	    main = len == source_name.size() &&
+	       source_name.compare(0, len, filename, len) == 0;
+	    if (main && between && length > 0) {
+	       cuts.push_back(Cut{std::size_t(line - begin),
+		  std::to_string(length) + ":" + hash.get_hex()});
+	    }
+	 }
+	 cp = eol; continue;
+      }
+      for (; cp < eol; ++cp) {
+	 char ch = *cp;
+	 if (comment) {
+	    if (ch == '*' && cp + 1 < eol && cp[1] == '/') {
+	       comment = false; ++cp;
+	    }
+	    continue;
+	 }
+	 if (ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r' ||
+	       ch == '\f' || ch == '\v') {
+	    continue;
+	 }
+	 if (ch == '/' && cp + 1 < eol && cp[1] == '*') {
+	    comment = true; ++cp; continue;
+	 }
+	 if (ch == '/' && cp + 1 < eol && cp[1] == '/') break;
+	 /* the first token of the main source ends the prefix */
+	 if (main) return cuts;
+	 if (ch == '"' || ch == '\'') {
+	    for (++cp; cp < eol && *cp != ch && *cp != '\n'; ++cp) {
+	       if (*cp == '\\' && cp + 1 < eol) ++cp;
+	    }
+	 } else if (ch == '(' || ch == '[' || ch == '{') {
+	    ++depth;
+	 } else if (ch == ')' || ch == ']' || ch == '}') {
+	    --depth;
+	 }
+	 between = depth == 0 && ch == ';';
+      }
+      cp = eol;
+   }
+   return cuts;
+}
+
+PrefixCache::PrefixPtr PrefixCache::lookup(
+      const std::string& fingerprint) const {
+   std::lock_guard<std::mutex> lock(mutex);
+   auto it = prefixes.find(fingerprint);
+   if (it == prefixes.end()) return nullptr;
+   return it->second;
+}
+
+// mutator ===================================================================
+
+PrefixCache::PrefixPtr PrefixCache::insert(const std::string& fingerprint,
+      const PrefixPtr& prefix) {
+   std::lock_guard<std::mutex> lock(mutex);
+   return prefixes.insert(std::make_pair(fingerprint, prefix)).first->second;
+}
+
+} // namespace AstlC
@@ -0,0 +1,81 @@
+/*
+   Copyright (C) 2026 The Astl-C contributors
+   ----------------------------------------------------------------------------
+   Astl-C is free software; you can redistribute it
+   and/or modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either version
+   2 of the License, or (at your option) any later version.
+
+   Astl-C is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+#ifndef ASTL_C_PREFIXCACHE_H
+#define ASTL_C_PREFIXCACHE_H
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <astl/syntax-tree.hpp>
+#include "symbol.hpp"
+
+namespace AstlC {
+
+   /* in-memory cache of the external declarations and the
+      file-scope symbols of the preprocessed headers at the beginning
+      of a source such that sources which include the same
+      headers share their parse, similar to precompiled headers */
+   class PrefixCache {
+      public:
+	 /* state of the parser at the end of a prefix */
+	 struct Prefix {
+	    std::vector<Astl::NodePtr> declarations;
+	    std::vector<Symbol> symbols; // in the order of declaration
+	 };
+	 typedef std::shared_ptr<const Prefix> PrefixPtr;
+
+	 /* position in a preprocessed source where the main source
+	    is resumed after a top-level #include and where the
+	    parser is between two external declarations */
+	 struct Cut {
+	    std::size_t offset;
+	    /* of all preceding text apart from that of the main source
+	       which consists of white space and linemarkers only */
+	    std::string fingerprint;
+	 };
+
+	 // constructor
+	 PrefixCache();
+
+	 // accessor
+	 /* returns the cuts of the headers included at the
+	    beginning of the preprocessed source */
+	 static std::vector<Cut> get_cuts(const char* begin,
+	    const char* end, const std::string& source_name);
+	 /* returns null if the prefix is not known yet */
+	 PrefixPtr lookup(const std::string& fingerprint) const;
+
+	 // mutator
+	 /* returns the prefix kept in the cache which is the given
+	    one unless another thread has been faster;
+	    this may be invoked by multiple threads in parallel */
+	 PrefixPtr insert(const std::string& fingerprint,
+	    const PrefixPtr& prefix);
+
+      private:
+	 mutable std::mutex mutex;
+	 std::map<std::string, PrefixPtr> prefixes;
+   };
+
+} // namespace AstlC
+
+#endif
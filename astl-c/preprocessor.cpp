@@ -0,0 +1,2075 @@
+/*
+   Copyright (C) 2026 The Astl-C contributors
+   ----------------------------------------------------------------------------
+   Astl-C is free software; you can redistribute it
+   and/or modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either version
+   2 of the License, or (at your option) any later version.
+
+   Astl-C is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+#include <sys/stat.h>
+#include <algorithm>
+#include <cassert>
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <deque>
+#include <iostream>
+#include <set>
+#include <sstream>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <astl/exception.hpp>
+#include "buffer.hpp"
+#include "filenames.hpp"
+#include "preprocessor.hpp"
+
+namespace AstlC {
+
+// private types =============================================================
+
+enum TokenKind {
+   IDENTIFIER, NUMBER, CHARACTER, STRING, PUNCTUATOR, OTHER,
+   END_OF_FILE, // end of the current file
+   END_OF_LIST, // end of a token list that is expanded separately
+};
+
+/* names of the macros which must not be expanded for a token,
+   see Prosser's algorithm; the lists are shared among tokens */
+struct HideSet {
+   const std::string* name;
+   const HideSet* next;
+};
+
+struct Token {
+   TokenKind kind;
+   const char* text; // not terminated by a null byte
+   std::size_t len;
+   const std::string* name; // interned text of identifiers
+   unsigned int line, column; // physical position within its file
+   bool bol; // first token of a line
+   bool space; // preceded by white space or a line break
+   bool expanded; // result of a macro expansion
+   const HideSet* hideset;
+
+   bool is(char ch) const {
+      return kind == PUNCTUATOR && len == 1 && *text == ch;
+   }
+   bool is(const char* s) const {
+      return kind == PUNCTUATOR && std::strlen(s) == len &&
+	 std::memcmp(text, s, len) == 0;
+   }
+   bool is_hash() const {
+      return is('#') || is("%:");
+   }
+   bool is_paste() const {
+      return is("##") || is("%:%:");
+   }
+   std::string spelling() const {
+      return std::string(text, len);
+   }
+};
+
+enum MacroKind {
+   REGULAR_MACRO, FILE_MACRO, LINE_MACRO, COUNTER_MACRO,
+   INCLUDE_LEVEL_MACRO, BASE_FILE_MACRO, DATE_MACRO, TIME_MACRO,
+};
+
+struct Macro {
+   MacroKind kind;
+   bool function_like;
+   bool variadic; // the last parameter takes all remaining arguments
+   std::vector<const std::string*> params;
+   std::vector<Token> body;
+};
+
+typedef std::unordered_map<const std::string*,
+   std::shared_ptr<const Macro>> MacroTable;
+
+// private functions =========================================================
+
+/* identifiers are interned such that they can be compared by their
+   addresses; elements of an unordered set do not move on rehashing */
+static std::mutex names_mutex;
+static std::unordered_set<std::string> names;
+
+static const std::string* intern_name(const std::string& name) {
+   std::lock_guard<std::mutex> lock(names_mutex);
+   return &*names.insert(name).first;
+}
+
+static const std::string* const name_define = intern_name("define");
+static const std::string* const name_defined = intern_name("defined");
+static const std::string* const name_elif = intern_name("elif");
+static const std::string* const name_elifdef = intern_name("elifdef");
+static const std::string* const name_elifndef = intern_name("elifndef");
+static const std::string* const name_else = intern_name("else");
+static const std::string* const name_endif = intern_name("endif");
+static const std::string* const name_error = intern_name("error");
+static const std::string* const name_if = intern_name("if");
+static const std::string* const name_ifdef = intern_name("ifdef");
+static const std::string* const name_ifndef = intern_name("ifndef");
+static const std::string* const name_ident = intern_name("ident");
+static const std::string* const name_import = intern_name("import");
+static const std::string* const name_include = intern_name("include");
+static const std::string* const name_include_next =
+   intern_name("include_next");
+static const std::string* const name_line = intern_name("line");
+static const std::string* const name_pragma = intern_name("pragma");
+static const std::string* const name_sccs = intern_name("sccs");
+static const std::string* const name_undef = intern_name("undef");
+static const std::string* const name_warning = intern_name("warning");
+static const std::string* const name_once = intern_name("once");
+static const std::string* const name_gcc = intern_name("GCC");
+static const std::string* const name_system_header =
+   intern_name("system_header");
+static const std::string* const name_push_macro = intern_name("push_macro");
+static const std::string* const name_pop_macro = intern_name("pop_macro");
+static const std::string* const name_va_args = intern_name("__VA_ARGS__");
+static const std::string* const name_va_opt = intern_name("__VA_OPT__");
+static const std::string* const name_pragma_operator =
+   intern_name("_Pragma");
+static const std::string* const name_has_include =
+   intern_name("__has_include");
+static const std::string* const name_has_include_next =
+   intern_name("__has_include_next");
+/* supported by gcc but answered with 0 as we cannot tell */
+static const std::string* const name_has_features[] = {
+   intern_name("__has_attribute"),
+   intern_name("__has_cpp_attribute"),
+   intern_name("__has_c_attribute"),
+   intern_name("__has_builtin"),
+};
+
+static bool is_has_feature(const std::string* name) {
+   for (auto feature: name_has_features) {
+      if (name == feature) return true;
+   }
+   return false;
+}
+
+static bool is_digit(unsigned char ch) {
+   return ch >= '0' && ch <= '9';
+}
+
+/* gcc accepts $ and UTF-8 encoded characters within identifiers */
+static bool is_ident_start(unsigned char ch) {
+   return (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') ||
+      ch == '_' || ch == '$' || ch >= 0x80;
+}
+
+static bool is_ident_char(unsigned char ch) {
+   return is_ident_start(ch) || is_digit(ch);
+}
+
+struct Punctuator {
+   const char* text;
+   std::size_t len;
+};
+
+/* all punctuators with more than one character, longest first */
+static const Punctuator punctuators[] = {
+   {"%:%:", 4}, {"...", 3}, {"<<=", 3}, {">>=", 3},
+   {"->", 2}, {"++", 2}, {"--", 2}, {"<<", 2}, {">>", 2}, {"<=", 2},
+   {">=", 2}, {"==", 2}, {"!=", 2}, {"&&", 2}, {"||", 2}, {"*=", 2},
+   {"/=", 2}, {"%=", 2}, {"+=", 2}, {"-=", 2}, {"&=", 2}, {"^=", 2},
+   {"|=", 2}, {"##", 2}, {"<:", 2}, {":>", 2}, {"<%", 2}, {"%>", 2},
+   {"%:", 2},
+};
+
+/* returns the end of the character constant or string literal
+   at cp or nullptr if it is not terminated on the same line */
+static const char* skip_quoted(const char* cp, const char* end) {
+   char quote = *cp++;
+   while (cp < end && *cp != quote && *cp != '\n') {
+      if (*cp == '\\' && cp + 1 < end && cp[1] != '\n') ++cp;
+      ++cp;
+   }
+   if (cp < end && *cp == quote) return cp + 1;
+   return nullptr;
+}
+
+/* returns the end of the preprocessing token which begins at cp;
+   line splices and comments are expected to be removed */
+static const char* lex_token(const char* cp, const char* end,
+      TokenKind& kind) {
+   unsigned char ch = *cp;
+   if (ch == 'L' || ch == 'u' || ch == 'U') {
+      /* prefixed character constants and string literals */
+      const char* p = cp + 1;
+      if (ch == 'u' && p < end && *p == '8') ++p;
+      if (p < end && (*p == '"' || *p == '\'')) {
+	 const char* q = skip_quoted(p, end);
+	 if (q) {
+	    kind = *p == '"'? STRING: CHARACTER;
+	    return q;
+	 }
+      }
+   }
+   if (is_ident_start(ch)) {
+      const char* p = cp + 1;
+      while (p < end && is_ident_char(*p)) ++p;
+      kind = IDENTIFIER; return p;
+   }
+   if (is_digit(ch) || (ch == '.' && cp + 1 < end && is_digit(cp[1]))) {
+      const char* p = cp + 1;
+      while (p < end) {
+	 if ((*p == '+' || *p == '-') && std::strchr("eEpP", p[-1])) {
+	    ++p;
+	 } else if (is_ident_char(*p) || *p == '.') {
+	    ++p;
+	 } else {
+	    break;
+	 }
+      }
+      kind = NUMBER; return p;
+   }
+   if (ch == '"' || ch == '\'') {
+      const char* p = skip_quoted(cp, end);
+      if (p) {
+	 kind = ch == '"'? STRING: CHARACTER;
+	 return p;
+      }
+      /* like gcc, we take a lone quote as a token of its own */
+      kind = OTHER; return cp + 1;
+   }
+   for (auto& punctuator: punctuators) {
+      if (std::size_t(end - cp) >= punctuator.len &&
+	    std::memcmp(cp, punctuator.text, punctuator.len) == 0) {
+	 kind = PUNCTUATOR; return cp + punctuator.len;
+      }
+   }
+   if (ch && std::strchr("[](){}.&*+-~!/%<>^|?:;=,#", ch)) {
+      kind = PUNCTUATOR; return cp + 1;
+   }
+   kind = OTHER; return cp + 1;
+}
+
+/* check whether a and b would be taken as one token
+   or as a comment if no white space separated them */
+static bool pastes(const Token& a, const Token& b) {
+   if (a.len == 0 || b.len == 0) return false;
+   if (a.text[a.len-1] == '/' && (*b.text == '/' || *b.text == '*')) {
+      return true;
+   }
+   std::string s = a.spelling() + b.spelling();
+   TokenKind kind;
+   return lex_token(s.data(), s.data() + s.size(), kind) !=
+      s.data() + a.len;
+}
+
+static std::string quote(const std::string& s) {
+   std::string result = "\"";
+   for (char ch: s) {
+      if (ch == '"' || ch == '\\') result += '\\';
+      result += ch;
+   }
+   result += '"';
+   return result;
+}
+
+/* spelling of the tokens beginning at index i separated by single
+   blanks where the original tokens were separated by white space */
+static std::string spell(const std::vector<Token>& tokens, std::size_t i) {
+   std::string text;
+   for (std::size_t first = i; i < tokens.size(); ++i) {
+      if (i > first && tokens[i].space) text += ' ';
+      text.append(tokens[i].text, tokens[i].len);
+   }
+   return text;
+}
+
+/* parse the definition of a macro from the tokens that follow
+   #define; returns nullptr and sets error if it is malformed */
+static std::shared_ptr<Macro> parse_macro(const std::vector<Token>& tokens,
+      std::size_t i, const std::string*& name, std::string& error) {
+   if (i >= tokens.size() || tokens[i].kind != IDENTIFIER) {
+      error = "macro names must be identifiers"; return nullptr;
+   }
+   name = tokens[i++].name;
+   if (name == name_defined) {
+      error = "\"defined\" cannot be used as a macro name"; return nullptr;
+   }
+   auto macro = std::make_shared<Macro>();
+   macro->kind = REGULAR_MACRO;
+   macro->function_like = false;
+   macro->variadic = false;
+   if (i < tokens.size() && tokens[i].is('(') && !tokens[i].space) {
+      macro->function_like = true;
+      ++i;
+      bool expect_param = false;
+      for(;;) {
+	 if (i >= tokens.size()) {
+	    error = "missing ')' in macro parameter list"; return nullptr;
+	 }
+	 const Token& token = tokens[i++];
+	 if (token.is(')') && !expect_param) break;
+	 if (token.is("...")) {
+	    macro->variadic = true;
+	    macro->params.push_back(name_va_args);
+	    if (i >= tokens.size() || !tokens[i].is(')')) {
+	       error = "missing ')' in macro parameter list"; return nullptr;
+	    }
+	    ++i; break;
+	 }
+	 if (token.kind != IDENTIFIER) {
+	    error = "expected parameter name, found \"" +
+	       token.spelling() + "\"";
+	    return nullptr;
+	 }
+	 macro->params.push_back(token.name);
+	 if (i < tokens.size() && tokens[i].is("...")) {
+	    /* GNU extension: named variable arguments */
+	    macro->variadic = true;
+	    ++i;
+	    if (i >= tokens.size() || !tokens[i].is(')')) {
+	       error = "missing ')' in macro parameter list"; return nullptr;
+	    }
+	    ++i; break;
+	 }
+	 if (i < tokens.size() && tokens[i].is(',')) {
+	    ++i; expect_param = true; continue;
+	 }
+	 if (i >= tokens.size() || !tokens[i].is(')')) {
+	    error = "expected ',' or ')' in macro parameter list";
+	    return nullptr;
+	 }
+	 ++i; break;
+      }
+   }
+   macro->body.assign(tokens.begin() + i, tokens.end());
+   if (macro->body.size() > 0) {
+      macro->body.front().space = false;
+      if (macro->body.front().is_paste() || macro->body.back().is_paste()) {
+	 error = "'##' cannot appear at either end of a macro expansion";
+	 return nullptr;
+      }
+   }
+   return macro;
+}
+
+/* tokens that follow a # at the beginning of a line
+   which is expected at position i */
+static std::vector<Token> directive_line(const std::vector<Token>& tokens,
+      std::size_t i) {
+   std::vector<Token> line;
+   while (!tokens[i].bol) {
+      line.push_back(tokens[i++]);
+   }
+   return line;
+}
+
+/* name of the macro of an include guard which embraces the whole file
+   in the form of #ifndef X or #if !defined X ... #endif */
+static const std::string* find_guard(const std::vector<Token>& tokens) {
+   if (!tokens[0].bol || !tokens[0].is_hash()) return nullptr;
+   std::vector<Token> line = directive_line(tokens, 1);
+   const std::string* guard = nullptr;
+   if (line.size() == 2 && line[0].name == name_ifndef &&
+	 line[1].kind == IDENTIFIER) {
+      guard = line[1].name;
+   } else if (line.size() >= 4 && line[0].name == name_if &&
+	 line[1].is('!') && line[2].name == name_defined) {
+      if (line.size() == 4 && line[3].kind == IDENTIFIER) {
+	 guard = line[3].name;
+      } else if (line.size() == 6 && line[3].is('(') &&
+	    line[4].kind == IDENTIFIER && line[5].is(')')) {
+	 guard = line[4].name;
+      }
+   }
+   if (!guard) return nullptr;
+   int depth = 0;
+   for (std::size_t i = line.size() + 1; tokens[i].kind != END_OF_FILE;
+	 ++i) {
+      if (!tokens[i].bol || !tokens[i].is_hash()) continue;
+      const Token& directive = tokens[i+1];
+      if (directive.bol || directive.kind != IDENTIFIER) continue;
+      if (directive.name == name_if || directive.name == name_ifdef ||
+	    directive.name == name_ifndef) {
+	 ++depth;
+      } else if (directive.name == name_endif) {
+	 if (depth == 0) {
+	    /* nothing must follow the final #endif */
+	    std::size_t j = i + 2;
+	    while (!tokens[j].bol) ++j;
+	    return tokens[j].kind == END_OF_FILE? guard: nullptr;
+	 }
+	 --depth;
+      } else if (depth == 0 && (directive.name == name_else ||
+	    directive.name == name_elif || directive.name == name_elifdef ||
+	    directive.name == name_elifndef)) {
+	 return nullptr;
+      }
+   }
+   return nullptr;
+}
+
+static std::string directory_of(const std::string& path) {
+   std::size_t slash = path.rfind('/');
+   if (slash == std::string::npos) return "";
+   return path.substr(0, slash);
+}
+
+static std::string join(const std::string& dir, const std::string& name) {
+   if (dir.empty()) return name;
+   return dir + "/" + name;
+}
+
+// private classes ===========================================================
+
+struct Preprocessor::SourceFile {
+   std::string path;
+   std::unique_ptr<SourceBuffer> buffer;
+   std::string spliced; // contents without line splices, if needed
+   std::vector<Token> tokens; // terminated by END_OF_FILE
+   const std::string* guard; // macro of the include guard, if any
+
+   SourceFile(const std::string& path) :
+	 path(path), buffer(new SourceBuffer(path)), guard(nullptr) {
+      tokenize();
+      guard = find_guard(tokens);
+   }
+   SourceFile(const std::string& path, std::string&& contents) :
+	 path(path), buffer(new SourceBuffer(std::move(contents))),
+	 guard(nullptr) {
+      tokenize();
+   }
+
+   void tokenize();
+};
+
+/* tokenize the whole file at once; positions are counted like
+   in the scanner, i.e. in bytes with tab stops at every 8 columns */
+void Preprocessor::SourceFile::tokenize() {
+   const char* begin = buffer->begin();
+   const char* end = buffer->end();
+   /* offsets into the spliced text where line splices were removed */
+   std::vector<std::size_t> splices;
+   for (const char* cp = begin; cp < end; ++cp) {
+      if (*cp != '\\') continue;
+      const char* next = cp + 1;
+      if (next < end && *next == '\r') ++next;
+      if (next < end && *next == '\n') {
+	 spliced.reserve(end - begin);
+	 for (cp = begin; cp < end; ++cp) {
+	    if (*cp == '\\') {
+	       next = cp + 1;
+	       if (next < end && *next == '\r') ++next;
+	       if (next < end && *next == '\n') {
+		  splices.push_back(spliced.size());
+		  cp = next; continue;
+	       }
+	    }
+	    spliced += *cp;
+	 }
+	 begin = spliced.data(); end = begin + spliced.size();
+	 break;
+      }
+   }
+
+   unsigned int line = 1, column = 1;
+   std::size_t splice_index = 0;
+   const char* cp = begin;
+   auto advance = [&](const char* to) {
+      while (cp < to) {
+	 if (*cp == '\n') {
+	    ++line; column = 1;
+	 } else if (*cp == '\t') {
+	    column += 8 - (column - 1) % 8;
+	 } else {
+	    ++column;
+	 }
+	 ++cp;
+	 while (splice_index < splices.size() &&
+	       splices[splice_index] == std::size_t(cp - begin)) {
+	    ++line; column = 1; ++splice_index;
+	 }
+      }
+   };
+   advance(cp); // in case of a splice at the very beginning
+   while (splice_index < splices.size() && splices[splice_index] == 0) {
+      ++line; column = 1; ++splice_index;
+   }
+   bool bol = true;
+   bool space = false;
+   while (cp < end) {
+      char ch = *cp;
+      if (ch == '\n') {
+	 advance(cp + 1); bol = true; space = false; continue;
+      }
+      if (ch == ' ' || ch == '\t' || ch == '\r' || ch == '\f' ||
+	    ch == '\v') {
+	 advance(cp + 1); space = true; continue;
+      }
+      if (ch == '/' && cp + 1 < end && cp[1] == '*') {
+	 const char* p = cp + 2;
+	 while (p + 1 < end && (p[0] != '*' || p[1] != '/')) ++p;
+	 advance(p + 1 < end? p + 2: end); space = true; continue;
+      }
+      if (ch == '/' && cp + 1 < end && cp[1] == '/') {
+	 const char* p = cp + 2;
+	 while (p < end && *p != '\n') ++p;
+	 advance(p); space = true; continue;
+      }
+      Token token;
+      token.text = cp;
+      token.len = lex_token(cp, end, token.kind) - cp;
+      token.name = token.kind == IDENTIFIER?
+	 intern_name(token.spelling()): nullptr;
+      token.line = line; token.column = column;
+      token.bol = bol; token.space = space || bol;
+      token.expanded = false;
+      token.hideset = nullptr;
+      tokens.push_back(token);
+      advance(cp + token.len);
+      bol = false; space = false;
+   }
+   Token eof;
+   eof.kind = END_OF_FILE;
+   eof.text = end; eof.len = 0; eof.name = nullptr;
+   eof.line = line; eof.column = column;
+   eof.bol = true; eof.space = true; eof.expanded = false;
+   eof.hideset = nullptr;
+   tokens.push_back(eof);
+}
+
+struct Preprocessor::Configuration {
+   std::vector<std::string> search; // quote dirs, then bracket dirs
+   std::size_t bracket_start; // index of the first bracket dir
+   Args includes; // files of -include options
+   std::unique_ptr<SourceFile> builtins; // output of -dM
+   MacroTable macros; // predefined macros
+};
+
+/* generator of the output in the syntax of gcc -E */
+class Emitter {
+   public:
+      Emitter() : filename(nullptr), line(0), column(1), has_prev(false) {
+      }
+
+      /* linemarker that announces the given line of the named file */
+      void marker(const std::string* name, long line, const char* flags) {
+	 if (column > 1) out += '\n';
+	 out += "# ";
+	 out += std::to_string(line);
+	 out += ' ';
+	 out += quote(*name);
+	 out += flags;
+	 out += '\n';
+	 filename = name; this->line = line; column = 1; has_prev = false;
+      }
+
+      void emit(const Token& token, const std::string* name, long line) {
+	 sync(name, line);
+	 if (column < token.column) {
+	    out.append(token.column - column, ' ');
+	    column = token.column;
+	 } else if (has_prev && (token.space ||
+	       ((token.expanded || prev.expanded) && pastes(prev, token)))) {
+	    out += ' '; ++column;
+	 }
+	 out.append(token.text, token.len);
+	 for (std::size_t i = 0; i < token.len; ++i) {
+	    if (token.text[i] == '\t') {
+	       column += 8 - (column - 1) % 8;
+	    } else {
+	       ++column;
+	    }
+	 }
+	 prev = token; has_prev = true;
+      }
+
+      void pragma(const std::string& text, const std::string* name,
+	    long line) {
+	 sync(name, line);
+	 if (column > 1) {
+	    out += '\n'; ++this->line;
+	 }
+	 out += "#pragma ";
+	 out += text;
+	 out += '\n';
+	 ++this->line; column = 1; has_prev = false;
+      }
+
+      std::string finish() {
+	 if (column > 1) out += '\n';
+	 return std::move(out);
+      }
+
+   private:
+      std::string out;
+      const std::string* filename; // of the current line
+      long line; // number of the current line
+      unsigned int column; // of the next character
+      Token prev; // preceding token on the current line
+      bool has_prev;
+
+      /* move to the given line, small gaps are filled with empty lines */
+      void sync(const std::string* name, long line) {
+	 if (name != filename || line < this->line || line > this->line + 8) {
+	    marker(name, line, "");
+	    return;
+	 }
+	 while (this->line < line) {
+	    out += '\n'; ++this->line; column = 1; has_prev = false;
+	 }
+      }
+};
+
+/* evaluation of the controlling expression of #if and #elif
+   after macro expansion */
+class ConstantExpression {
+   public:
+      ConstantExpression(const std::vector<Token>& tokens) :
+	 tokens(tokens), pos(0) {
+      }
+
+      /* returns false and sets error if the expression is malformed */
+      bool evaluate(bool& result, std::string& error) {
+	 try {
+	    if (tokens.empty()) fail("#if with no expression");
+	    Value value = expression(true);
+	    if (pos < tokens.size()) {
+	       fail("missing binary operator before token \"" +
+		  tokens[pos].spelling() + "\"");
+	    }
+	    result = value.value != 0;
+	    return true;
+	 } catch (std::string& message) {
+	    error = message;
+	    return false;
+	 }
+      }
+
+   private:
+      struct Value {
+	 std::uint64_t value;
+	 bool is_unsigned;
+      };
+
+      const std::vector<Token>& tokens;
+      std::size_t pos;
+
+      static void fail(const std::string& message) {
+	 throw message;
+      }
+      static Value make(std::uint64_t value, bool is_unsigned = false) {
+	 return Value{value, is_unsigned};
+      }
+      static bool less(const Value& a, const Value& b) {
+	 if (a.is_unsigned || b.is_unsigned) return a.value < b.value;
+	 return std::int64_t(a.value) < std::int64_t(b.value);
+      }
+
+      bool accept(const char* op) {
+	 if (pos < tokens.size() && tokens[pos].is(op)) {
+	    ++pos; return true;
+	 }
+	 return false;
+      }
+      void expect(const char* op) {
+	 if (!accept(op)) {
+	    if (pos < tokens.size()) {
+	       fail("expected '" + std::string(op) + "' before \"" +
+		  tokens[pos].spelling() + "\"");
+	    }
+	    fail("expected '" + std::string(op) + "' in expression");
+	 }
+      }
+
+      Value expression(bool eval) {
+	 Value value = conditional(eval);
+	 while (accept(",")) {
+	    value = conditional(eval);
+	 }
+	 return value;
+      }
+      Value conditional(bool eval) {
+	 Value condition = logical_or(eval);
+	 if (!accept("?")) return condition;
+	 bool taken = condition.value != 0;
+	 Value a = expression(eval && taken);
+	 expect(":");
+	 Value b = conditional(eval && !taken);
+	 Value result = taken? a: b;
+	 result.is_unsigned = a.is_unsigned || b.is_unsigned;
+	 return result;
+      }
+      Value logical_or(bool eval) {
+	 Value value = logical_and(eval);
+	 while (accept("||")) {
+	    bool left = value.value != 0;
+	    Value right = logical_and(eval && !left);
+	    value = make(left || right.value != 0);
+	 }
+	 return value;
+      }
+      Value logical_and(bool eval) {
+	 Value value = bit_or(eval);
+	 while (accept("&&")) {
+	    bool left = value.value != 0;
+	    Value right = bit_or(eval && left);
+	    value = make(left && right.value != 0);
+	 }
+	 return value;
+      }
+      Value bit_or(bool eval) {
+	 Value value = bit_xor(eval);
+	 while (accept("|")) {
+	    Value right = bit_xor(eval);
+	    value = make(value.value | right.value,
+	       value.is_unsigned || right.is_unsigned);
+	 }
+	 return value;
+      }
+      Value bit_xor(bool eval) {
+	 Value value = bit_and(eval);
+	 while (accept("^")) {
+	    Value right = bit_and(eval);
+	    value = make(value.value ^ right.value,
+	       value.is_unsigned || right.is_unsigned);
+	 }
+	 return value;
+      }
+      Value bit_and(bool eval) {
+	 Value value = equality(eval);
+	 while (accept("&")) {
+	    Value right = equality(eval);
+	    value = make(value.value & right.value,
+	       value.is_unsigned || right.is_unsigned);
+	 }
+	 return value;
+      }
+      Value equality(bool eval) {
+	 Value value = relational(eval);
+	 for(;;) {
+	    if (accept("==")) {
+	       value = make(value.value == relational(eval).value);
+	    } else if (accept("!=")) {
+	       value = make(value.value != relational(eval).value);
+	    } else {
+	       return value;
+	    }
+	 }
+      }
+      Value relational(bool eval) {
+	 Value value = shift(eval);
+	 for(;;) {
+	    if (accept("<")) {
+	       Value right = shift(eval);
+	       value = make(less(value, right));
+	    } else if (accept(">")) {
+	       Value right = shift(eval);
+	       value = make(less(right, value));
+	    } else if (accept("<=")) {
+	       Value right = shift(eval);
+	       value = make(!less(right, value));
+	    } else if (accept(">=")) {
+	       Value right = shift(eval);
+	       value = make(!less(value, right));
+	    } else {
+	       return value;
+	    }
+	 }
+      }
+      Value shift(bool eval) {
+	 Value value = additive(eval);
+	 for(;;) {
+	    bool left;
+	    if (accept("<<")) {
+	       left = true;
+	    } else if (accept(">>")) {
+	       left = false;
+	    } else {
+	       return value;
+	    }
+	    Value right = additive(eval);
+	    std::int64_t count = right.value;
+	    if (!right.is_unsigned && count < 0) {
+	       left = !left; count = -count;
+	    }
+	    if (left) {
+	       value.value = count >= 64? 0: value.value << count;
+	    } else if (value.is_unsigned) {
+	       value.value = count >= 64? 0: value.value >> count;
+	    } else {
+	       std::int64_t v = value.value;
+	       value.value = v >> (count >= 64? 63: count);
+	    }
+	 }
+      }
+      Value additive(bool eval) {
+	 Value value = multiplicative(eval);
+	 for(;;) {
+	    if (accept("+")) {
+	       Value right = multiplicative(eval);
+	       value = make(value.value + right.value,
+		  value.is_unsigned || right.is_unsigned);
+	    } else if (accept("-")) {
+	       Value right = multiplicative(eval);
+	       value = make(value.value - right.value,
+		  value.is_unsigned || right.is_unsigned);
+	    } else {
+	       return value;
+	    }
+	 }
+      }
+      Value multiplicative(bool eval) {
+	 Value value = unary(eval);
+	 for(;;) {
+	    char op;
+	    if (accept("*")) {
+	       op = '*';
+	    } else if (accept("/")) {
+	       op = '/';
+	    } else if (accept("%")) {
+	       op = '%';
+	    } else {
+	       return value;
+	    }
+	    Value right = unary(eval);
+	    bool is_unsigned = value.is_unsigned || right.is_unsigned;
+	    if (op == '*') {
+	       value = make(value.value * right.value, is_unsigned);
+	       continue;
+	    }
+	    if (right.value == 0) {
+	       if (eval) fail("division by zero in #if");
+	       value = make(0, is_unsigned);
+	    } else if (is_unsigned) {
+	       value = make(op == '/'? value.value / right.value:
+		  value.value % right.value, true);
+	    } else {
+	       std::int64_t a = value.value;
+	       std::int64_t b = right.value;
+	       if (b == -1) {
+		  /* avoid the overflow of INT64_MIN / -1 */
+		  value = make(op == '/'? -value.value: 0);
+	       } else {
+		  value = make(op == '/'? a / b: a % b);
+	       }
+	    }
+	 }
+      }
+      Value unary(bool eval) {
+	 if (accept("+")) return unary(eval);
+	 if (accept("-")) {
+	    Value value = unary(eval);
+	    value.value = -value.value;
+	    return value;
+	 }
+	 if (accept("~")) {
+	    Value value = unary(eval);
+	    value.value = ~value.value;
+	    return value;
+	 }
+	 if (accept("!")) {
+	    return make(unary(eval).value == 0);
+	 }
+	 return primary(eval);
+      }
+      Value primary(bool eval) {
+	 if (pos >= tokens.size()) fail("#if with incomplete expression");
+	 if (accept("(")) {
+	    Value value = expression(eval);
+	    expect(")");
+	    return value;
+	 }
+	 const Token& token = tokens[pos++];
+	 switch (token.kind) {
+	    case NUMBER: return number(token);
+	    case CHARACTER: return character(token);
+	    case IDENTIFIER: return make(0); // not defined as macro
+	    default:
+	       fail("token \"" + token.spelling() +
+		  "\" is not valid in preprocessor expressions");
+	       return make(0);
+	 }
+      }
+
+      static Value number(const Token& token) {
+	 std::string text = token.spelling();
+	 bool is_unsigned = false;
+	 while (!text.empty() && std::strchr("uUlL", text.back())) {
+	    if (text.back() == 'u' || text.back() == 'U') is_unsigned = true;
+	    text.pop_back();
+	 }
+	 unsigned int base = 10;
+	 std::size_t i = 0;
+	 if (text.size() > 1 && text[0] == '0' &&
+	       (text[1] == 'x' || text[1] == 'X')) {
+	    base = 16; i = 2;
+	 } else if (text.size() > 1 && text[0] == '0' &&
+	       (text[1] == 'b' || text[1] == 'B')) {
+	    base = 2; i = 2;
+	 } else if (text.size() > 1 && text[0] == '0') {
+	    base = 8; i = 1;
+	 }
+	 if (i == text.size() && base != 8) {
+	    fail("invalid integer constant \"" + token.spelling() + "\"");
+	 }
+	 std::uint64_t value = 0;
+	 bool overflow = false;
+	 for (; i < text.size(); ++i) {
+	    char ch = text[i];
+	    unsigned int digit;
+	    if (ch >= '0' && ch <= '9') {
+	       digit = ch - '0';
+	    } else if (ch >= 'a' && ch <= 'f') {
+	       digit = ch - 'a' + 10;
+	    } else if (ch >= 'A' && ch <= 'F') {
+	       digit = ch - 'A' + 10;
+	    } else {
+	       digit = base;
+	    }
+	    if (digit >= base) {
+	       if (ch == '.' || ((ch == 'e' || ch == 'E') && base != 16) ||
+		     ((ch == 'p' || ch == 'P') && base == 16)) {
+		  fail("floating constant in preprocessor expression");
+	       }
+	       fail("invalid integer constant \"" + token.spelling() + "\"");
+	    }
+	    if (value > (UINT64_MAX - digit) / base) overflow = true;
+	    value = value * base + digit;
+	 }
+	 if (overflow) {
+	    fail("integer constant is too large for its type");
+	 }
+	 if (value > std::uint64_t(INT64_MAX)) is_unsigned = true;
+	 return make(value, is_unsigned);
+      }
+
+      static Value character(const Token& token) {
+	 const char* cp = token.text;
+	 const char* end = token.text + token.len - 1; // closing quote
+	 bool wide = false;
+	 bool is_unsigned = false;
+	 if (*cp == 'L') {
+	    wide = true; ++cp;
+	 } else if (*cp == 'u' || *cp == 'U') {
+	    wide = true; is_unsigned = true; ++cp;
+	    if (*cp == '8') {
+	       wide = false; ++cp;
+	    }
+	 }
+	 ++cp; // opening quote
+	 std::uint64_t value = 0;
+	 unsigned int count = 0;
+	 while (cp < end) {
+	    std::uint64_t ch = static_cast<unsigned char>(*cp++);
+	    if (ch == '\\' && cp < end) {
+	       ch = static_cast<unsigned char>(*cp++);
+	       switch (ch) {
+		  case 'a': ch = '\a'; break;
+		  case 'b': ch = '\b'; break;
+		  case 'e': ch = 27; break;
+		  case 'f': ch = '\f'; break;
+		  case 'n': ch = '\n'; break;
+		  case 'r': ch = '\r'; break;
+		  case 't': ch = '\t'; break;
+		  case 'v': ch = '\v'; break;
+		  case 'x':
+		     ch = 0;
+		     while (cp < end && std::isxdigit(
+			   static_cast<unsigned char>(*cp))) {
+			char digit = *cp++;
+			ch = ch * 16 + (is_digit(digit)? digit - '0':
+			   (digit | 0x20) - 'a' + 10);
+		     }
+		     break;
+		  default:
+		     if (ch >= '0' && ch <= '7') {
+			ch -= '0';
+			for (int i = 0; i < 2 && cp < end &&
+			      *cp >= '0' && *cp <= '7'; ++i) {
+			   ch = ch * 8 + (*cp++ - '0');
+			}
+		     }
+		     break;
+	       }
+	    }
+	    if (wide) {
+	       value = ch;
+	    } else {
+	       value = (value << 8) | (ch & 0xff);
+	    }
+	    ++count;
+	 }
+	 if (!wide && !is_unsigned && count == 1) {
+	    /* plain char is signed */
+	    value = std::int64_t(static_cast<signed char>(value));
+	 } else if (wide && !is_unsigned) {
+	    value = std::int64_t(static_cast<std::int32_t>(value));
+	 }
+	 return make(value, is_unsigned);
+      }
+};
+
+/* preprocessing of one source */
+class Preprocessor::Unit {
+   public:
+      Unit(const Preprocessor& preprocessor, const Configuration& config,
+	    const std::string& input_file) :
+	    preprocessor(preprocessor), config(config),
+	    input_file(input_file), macros(config.macros),
+	    counter(0), success(true) {
+      }
+
+      std::string run(bool& success) {
+	 /* files of -include options are searched for in the
+	    working directory first */
+	 for (auto& name: config.includes) {
+	    std::size_t dir = std::string::npos;
+	    auto file = preprocessor.get_file(name);
+	    if (!file) {
+	       for (std::size_t i = 0; i < config.search.size(); ++i) {
+		  file = preprocessor.get_file(join(config.search[i], name));
+		  if (file) {
+		     dir = i; break;
+		  }
+	       }
+	    }
+	    if (!file) {
+	       std::cerr << name << ": No such file or directory" <<
+		  std::endl;
+	       this->success = false;
+	       continue;
+	    }
+	    push_file(file, dir, 1);
+	    process();
+	 }
+	 auto file = preprocessor.get_file(input_file);
+	 if (!file) {
+	    std::ostringstream os;
+	    os << "unable to open " << input_file << " for reading";
+	    throw Astl::Exception(os.str());
+	 }
+	 push_file(file, std::string::npos, 1);
+	 process();
+	 success = this->success;
+	 return emitter.finish();
+      }
+
+   private:
+      struct Frame {
+	 std::shared_ptr<const SourceFile> file;
+	 std::size_t pos; // index of the next token
+	 const std::string* name; // presumed filename, see #line
+	 long line_delta; // presumed minus physical line number
+	 std::size_t dir; // index into the search path, if found there
+	 std::size_t conditionals; // depth of conditionals at entry
+	 long return_line; // presumed line of the includer after #include
+      };
+      struct Conditional {
+	 bool taken; // one of the groups has been taken
+	 bool in_else; // #else has been seen
+      };
+
+      static constexpr std::size_t max_include_depth = 200;
+
+      const Preprocessor& preprocessor;
+      const Configuration& config;
+      std::string input_file;
+      MacroTable macros;
+      std::map<const std::string*, std::vector<std::shared_ptr<const Macro>>>
+	 pushed_macros; // see #pragma push_macro
+      std::set<const SourceFile*> once; // see #pragma once
+      std::vector<Frame> frames; // nested includes
+      std::vector<Token> pending; // tokens to be read first, in reverse
+      std::vector<Conditional> conditionals;
+      std::deque<HideSet> hidesets;
+      std::deque<std::string> texts; // of tokens created by us
+      Emitter emitter;
+      unsigned long counter; // for __COUNTER__
+      bool success;
+
+      // diagnostics
+
+      void report(const Token& token, const char* kind,
+	    const std::string& message) {
+	 std::ostringstream os;
+	 if (!frames.empty()) {
+	    const Frame& frame = frames.back();
+	    os << *frame.name << ":" << token.line + frame.line_delta <<
+	       ":" << token.column << ": ";
+	 }
+	 os << kind << ": " << message << std::endl;
+	 std::cerr << os.str();
+      }
+      void error(const Token& token, const std::string& message) {
+	 report(token, "error", message);
+	 success = false;
+      }
+      void warning(const Token& token, const std::string& message) {
+	 report(token, "warning", message);
+      }
+
+      // reading tokens
+
+      void push_file(const std::shared_ptr<const SourceFile>& file,
+	    std::size_t dir, long return_line) {
+	 frames.push_back(Frame{file, 0, intern_filename(file->path), 0,
+	    dir, conditionals.size(), return_line});
+	 emitter.marker(frames.back().name, 1, frames.size() > 1? " 1": "");
+      }
+
+      /* next token, directives are processed on the fly;
+	 END_OF_FILE is returned at the end of the current file */
+      Token read() {
+	 if (!pending.empty()) {
+	    Token token = pending.back(); pending.pop_back();
+	    return token;
+	 }
+	 for(;;) {
+	    Frame& frame = frames.back();
+	    Token token = frame.file->tokens[frame.pos];
+	    if (token.kind == END_OF_FILE) return token;
+	    ++frame.pos;
+	    if (token.bol && token.is_hash()) {
+	       directive(token);
+	       continue;
+	    }
+	    return token;
+	 }
+      }
+
+      /* remaining tokens of the current directive */
+      std::vector<Token> read_line() {
+	 Frame& frame = frames.back();
+	 std::vector<Token> line = directive_line(frame.file->tokens,
+	    frame.pos);
+	 frame.pos += line.size();
+	 return line;
+      }
+
+      /* process the current file up to its end */
+      void process() {
+	 for(;;) {
+	    Token token = read();
+	    if (token.kind == END_OF_FILE) {
+	       const Frame& frame = frames.back();
+	       if (conditionals.size() > frame.conditionals) {
+		  error(token, "unterminated conditional directive");
+		  conditionals.resize(frame.conditionals);
+	       }
+	       long return_line = frame.return_line;
+	       frames.pop_back();
+	       if (frames.empty()) return;
+	       emitter.marker(frames.back().name, return_line, " 2");
+	       continue;
+	    }
+	    if (token.kind == IDENTIFIER &&
+		  token.name == name_pragma_operator &&
+		  macros.find(token.name) == macros.end()) {
+	       pragma_operator(token);
+	       continue;
+	    }
+	    if (expand(token)) continue;
+	    const Frame& frame = frames.back();
+	    emitter.emit(token, frame.name, token.line + frame.line_delta);
+	 }
+      }
+
+      // directives
+
+      void directive(const Token& hash) {
+	 std::vector<Token> line = read_line();
+	 if (line.empty()) return; // null directive
+	 const Token& token = line[0];
+	 if (token.kind == NUMBER) {
+	    /* linemarker in the syntax of gcc -E */
+	    line_directive(line, 0);
+	    return;
+	 }
+	 if (token.kind != IDENTIFIER) {
+	    error(token, "invalid preprocessing directive");
+	    return;
+	 }
+	 const std::string* name = token.name;
+	 if (name == name_define) {
+	    const std::string* macro_name;
+	    std::string message;
+	    auto macro = parse_macro(line, 1, macro_name, message);
+	    if (macro) {
+	       macros[macro_name] = macro;
+	    } else {
+	       error(token, message);
+	    }
+	 } else if (name == name_undef) {
+	    if (line.size() < 2 || line[1].kind != IDENTIFIER) {
+	       error(token, "macro names must be identifiers");
+	    } else {
+	       macros.erase(line[1].name);
+	    }
+	 } else if (name == name_include || name == name_import) {
+	    include(line, false);
+	 } else if (name == name_include_next) {
+	    include(line, frames.size() > 1);
+	 } else if (name == name_if) {
+	    conditionals.push_back(Conditional{false, false});
+	    enter_group(evaluate(line));
+	 } else if (name == name_ifdef || name == name_ifndef) {
+	    conditionals.push_back(Conditional{false, false});
+	    enter_group(is_defined(line) == (name == name_ifdef));
+	 } else if (name == name_elif || name == name_elifdef ||
+	       name == name_elifndef) {
+	    if (!in_conditional(token)) return;
+	    Conditional& conditional = conditionals.back();
+	    if (conditional.in_else) {
+	       error(token, "#" + *name + " after #else");
+	    }
+	    if (conditional.taken) {
+	       skip_group();
+	    } else if (name == name_elif) {
+	       enter_group(evaluate(line));
+	    } else {
+	       enter_group(is_defined(line) == (name == name_elifdef));
+	    }
+	 } else if (name == name_else) {
+	    if (!in_conditional(token)) return;
+	    Conditional& conditional = conditionals.back();
+	    if (conditional.in_else) {
+	       error(token, "#else after #else");
+	    }
+	    conditional.in_else = true;
+	    if (conditional.taken) {
+	       skip_group();
+	    } else {
+	       conditional.taken = true;
+	    }
+	 } else if (name == name_endif) {
+	    if (!in_conditional(token)) return;
+	    conditionals.pop_back();
+	 } else if (name == name_line) {
+	    line_directive(line, 1);
+	 } else if (name == name_error) {
+	    error(token, "#error " + spell(line, 1));
+	 } else if (name == name_warning) {
+	    warning(token, "#warning " + spell(line, 1));
+	 } else if (name == name_pragma) {
+	    pragma(line, hash);
+	 } else if (name == name_ident || name == name_sccs) {
+	    // ignored
+	 } else {
+	    error(token, "invalid preprocessing directive #" + *name);
+	 }
+      }
+
+      // conditional inclusion
+
+      bool in_conditional(const Token& token) {
+	 if (conditionals.size() <= frames.back().conditionals) {
+	    error(token, "#" + *token.name + " without #if");
+	    return false;
+	 }
+	 return true;
+      }
+
+      void enter_group(bool condition) {
+	 if (condition) {
+	    conditionals.back().taken = true;
+	 } else {
+	    skip_group();
+	 }
+      }
+
+      /* skip everything up to the next #elif, #else, or #endif
+	 of the current conditional which is left to be processed */
+      void skip_group() {
+	 Frame& frame = frames.back();
+	 const std::vector<Token>& tokens = frame.file->tokens;
+	 int depth = 0;
+	 for (;; ++frame.pos) {
+	    const Token& token = tokens[frame.pos];
+	    if (token.kind == END_OF_FILE) return;
+	    if (!token.bol || !token.is_hash()) continue;
+	    const Token& directive = tokens[frame.pos + 1];
+	    if (directive.bol || directive.kind != IDENTIFIER) continue;
+	    const std::string* name = directive.name;
+	    if (name == name_if || name == name_ifdef ||
+		  name == name_ifndef) {
+	       ++depth;
+	    } else if (name == name_endif) {
+	       if (depth == 0) return;
+	       --depth;
+	    } else if (depth == 0 && (name == name_elif ||
+		  name == name_elifdef || name == name_elifndef ||
+		  name == name_else)) {
+	       return;
+	    }
+	 }
+      }
+
+      bool is_defined(const std::string* name) const {
+	 return macros.find(name) != macros.end() ||
+	    name == name_has_include || name == name_has_include_next ||
+	    is_has_feature(name);
+      }
+
+      /* operand of #ifdef and its relatives */
+      bool is_defined(const std::vector<Token>& line) {
+	 if (line.size() < 2 || line[1].kind != IDENTIFIER) {
+	    error(line[0], "no macro name given in #" + *line[0].name +
+	       " directive");
+	    return false;
+	 }
+	 return is_defined(line[1].name);
+      }
+
+      bool evaluate(const std::vector<Token>& line) {
+	 std::vector<Token> tokens = expand_condition(
+	    std::vector<Token>(line.begin() + 1, line.end()));
+	 ConstantExpression expression(tokens);
+	 bool result;
+	 std::string message;
+	 if (!expression.evaluate(result, message)) {
+	    error(line[0], message);
+	    return false;
+	 }
+	 return result;
+      }
+
+      /* macro expansion of the controlling expression of #if and #elif
+	 where defined and __has_include are evaluated on the fly */
+      std::vector<Token> expand_condition(const std::vector<Token>& tokens) {
+	 push_list(tokens);
+	 std::vector<Token> result;
+	 for(;;) {
+	    Token token = read();
+	    if (token.kind == END_OF_LIST) break;
+	    if (token.kind == IDENTIFIER) {
+	       if (token.name == name_defined) {
+		  result.push_back(number_token(defined_operator(token),
+		     token));
+		  continue;
+	       }
+	       if (token.name == name_has_include ||
+		     token.name == name_has_include_next) {
+		  result.push_back(number_token(has_include_operator(token),
+		     token));
+		  continue;
+	       }
+	       if (is_has_feature(token.name)) {
+		  skip_parenthesized(token);
+		  result.push_back(number_token(0, token));
+		  continue;
+	       }
+	    }
+	    if (!expand(token)) result.push_back(token);
+	 }
+	 return result;
+      }
+
+      /* the end of a list must not be consumed by an operator */
+      Token read_operand() {
+	 Token token = read();
+	 if (token.kind == END_OF_LIST) pending.push_back(token);
+	 return token;
+      }
+
+      bool defined_operator(const Token& op) {
+	 Token token = read_operand();
+	 bool parenthesized = token.is('(');
+	 if (parenthesized) token = read_operand();
+	 if (token.kind != IDENTIFIER) {
+	    error(op, "operator \"defined\" requires an identifier");
+	    return false;
+	 }
+	 if (parenthesized && !read_operand().is(')')) {
+	    error(op, "missing ')' after \"defined\"");
+	 }
+	 return is_defined(token.name);
+      }
+
+      bool has_include_operator(const Token& op) {
+	 if (!read_operand().is('(')) {
+	    error(op, "missing '(' after \"" + *op.name + "\"");
+	    return false;
+	 }
+	 std::vector<Token> tokens;
+	 int depth = 0;
+	 for(;;) {
+	    Token token = read_operand();
+	    if (token.kind == END_OF_LIST) {
+	       error(op, "missing ')' after \"" + *op.name + "\" operand");
+	       return false;
+	    }
+	    if (token.is('(')) ++depth;
+	    if (token.is(')') && depth-- == 0) break;
+	    tokens.push_back(token);
+	 }
+	 std::string name;
+	 bool quoted;
+	 if (!header_name(tokens, 0, name, quoted)) {
+	    tokens = expand_list(tokens);
+	    if (!header_name(tokens, 0, name, quoted)) {
+	       error(op, "operator \"" + *op.name +
+		  "\" requires a header-name");
+	       return false;
+	    }
+	 }
+	 std::size_t dir;
+	 bool next = op.name == name_has_include_next && frames.size() > 1;
+	 return find_include(name, quoted, next, dir) != nullptr;
+      }
+
+      void skip_parenthesized(const Token& op) {
+	 if (!read_operand().is('(')) {
+	    error(op, "missing '(' after \"" + *op.name + "\"");
+	    return;
+	 }
+	 int depth = 0;
+	 for(;;) {
+	    Token token = read_operand();
+	    if (token.kind == END_OF_LIST) {
+	       error(op, "missing ')' after \"" + *op.name + "\" operand");
+	       return;
+	    }
+	    if (token.is('(')) ++depth;
+	    if (token.is(')') && depth-- == 0) return;
+	 }
+      }
+
+      // source file inclusion
+
+      static bool header_name(const std::vector<Token>& tokens,
+	    std::size_t i, std::string& name, bool& quoted) {
+	 if (i >= tokens.size()) return false;
+	 const Token& token = tokens[i];
+	 if (token.kind == STRING && token.text[0] == '"') {
+	    name = std::string(token.text + 1, token.len - 2);
+	    quoted = true;
+	    return true;
+	 }
+	 if (!token.is('<')) return false;
+	 name.clear();
+	 for (++i; i < tokens.size() && !tokens[i].is('>'); ++i) {
+	    if (tokens[i].space && !name.empty()) name += ' ';
+	    name.append(tokens[i].text, tokens[i].len);
+	 }
+	 quoted = false;
+	 return i < tokens.size();
+      }
+
+      std::shared_ptr<const SourceFile> find_include(const std::string& name,
+	    bool quoted, bool next, std::size_t& dir) const {
+	 dir = std::string::npos;
+	 if (!name.empty() && name[0] == '/') {
+	    return preprocessor.get_file(name);
+	 }
+	 const Frame& frame = frames.back();
+	 std::size_t start = quoted? 0: config.bracket_start;
+	 if (next && frame.dir != std::string::npos) {
+	    start = frame.dir + 1;
+	 } else if (quoted) {
+	    /* look into the directory of the current file first */
+	    auto file = preprocessor.get_file(
+	       join(directory_of(frame.file->path), name));
+	    if (file) return file;
+	 }
+	 for (std::size_t i = start; i < config.search.size(); ++i) {
+	    auto file = preprocessor.get_file(join(config.search[i], name));
+	    if (file) {
+	       dir = i; return file;
+	    }
+	 }
+	 return nullptr;
+      }
+
+      void include(const std::vector<Token>& line, bool next) {
+	 std::string name;
+	 bool quoted;
+	 if (!header_name(line, 1, name, quoted)) {
+	    /* computed include */
+	    std::vector<Token> tokens(line.begin() + 1, line.end());
+	    if (!header_name(expand_list(tokens), 0, name, quoted)) {
+	       error(line[0], "#include expects \"FILENAME\" or <FILENAME>");
+	       return;
+	    }
+	 }
+	 std::size_t dir;
+	 auto file = find_include(name, quoted, next, dir);
+	 if (!file) {
+	    error(line[0], name + ": No such file or directory");
+	    return;
+	 }
+	 if (once.find(file.get()) != once.end()) return;
+	 if (file->guard && macros.find(file->guard) != macros.end()) return;
+	 if (frames.size() >= max_include_depth) {
+	    error(line[0], "#include nested too deeply");
+	    return;
+	 }
+	 const Frame& frame = frames.back();
+	 long return_line = line.back().line + 1 + frame.line_delta;
+	 push_file(file, dir, return_line);
+      }
+
+      // other directives
+
+      void line_directive(const std::vector<Token>& line, std::size_t i) {
+	 std::vector<Token> tokens(line.begin() + i, line.end());
+	 if (i > 0) tokens = expand_list(tokens);
+	 const Token& token = line[0];
+	 if (tokens.empty() || tokens[0].kind != NUMBER ||
+	       !std::all_of(tokens[0].text, tokens[0].text + tokens[0].len,
+		  is_digit)) {
+	    error(token, "#line directive requires a positive integer");
+	    return;
+	 }
+	 long number = std::stol(tokens[0].spelling());
+	 Frame& frame = frames.back();
+	 frame.line_delta = number - long(line.back().line + 1);
+	 if (tokens.size() > 1) {
+	    if (tokens[1].kind != STRING || tokens[1].text[0] != '"') {
+	       error(token, "invalid filename in #line directive");
+	       return;
+	    }
+	    frame.name = intern_filename(destringize(tokens[1]));
+	 }
+      }
+
+      void pragma(const std::vector<Token>& line, const Token& hash) {
+	 if (line.size() >= 2 && line[1].name == name_once) {
+	    once.insert(frames.back().file.get());
+	    return;
+	 }
+	 if (line.size() >= 3 && line[1].name == name_gcc &&
+	       line[2].name == name_system_header) {
+	    return;
+	 }
+	 if (line.size() == 5 && (line[1].name == name_push_macro ||
+	       line[1].name == name_pop_macro) && line[2].is('(') &&
+	       line[3].kind == STRING && line[4].is(')')) {
+	    const std::string* name = intern_name(destringize(line[3]));
+	    auto& stack = pushed_macros[name];
+	    if (line[1].name == name_push_macro) {
+	       auto it = macros.find(name);
+	       stack.push_back(it == macros.end()? nullptr: it->second);
+	    } else if (!stack.empty()) {
+	       if (stack.back()) {
+		  macros[name] = stack.back();
+	       } else {
+		  macros.erase(name);
+	       }
+	       stack.pop_back();
+	    }
+	    return;
+	 }
+	 const Frame& frame = frames.back();
+	 emitter.pragma(spell(line, 1), frame.name,
+	    hash.line + frame.line_delta);
+      }
+
+      /* _Pragma("...") */
+      void pragma_operator(const Token& op) {
+	 Token open = read();
+	 Token literal = open.is('(')? read(): open;
+	 Token close = literal.kind == STRING? read(): literal;
+	 if (!open.is('(') || literal.kind != STRING || !close.is(')')) {
+	    error(op, "_Pragma takes a parenthesized string literal");
+	    if (close.kind == END_OF_FILE || close.kind == END_OF_LIST) {
+	       pending.push_back(close);
+	    }
+	    return;
+	 }
+	 const Frame& frame = frames.back();
+	 emitter.pragma(destringize(literal), frame.name,
+	    op.line + frame.line_delta);
+      }
+
+      static std::string destringize(const Token& token) {
+	 const char* cp = token.text;
+	 while (*cp != '"') ++cp; // skip prefix
+	 const char* end = token.text + token.len - 1;
+	 std::string text;
+	 for (++cp; cp < end; ++cp) {
+	    if (*cp == '\\' && cp + 1 < end &&
+		  (cp[1] == '"' || cp[1] == '\\')) {
+	       ++cp;
+	    }
+	    text += *cp;
+	 }
+	 return text;
+      }
+
+      // macro expansion
+
+      static bool hidden(const HideSet* hideset, const std::string* name) {
+	 for (; hideset; hideset = hideset->next) {
+	    if (hideset->name == name) return true;
+	 }
+	 return false;
+      }
+      const HideSet* hideset_add(const HideSet* hideset,
+	    const std::string* name) {
+	 hidesets.push_back(HideSet{name, hideset});
+	 return &hidesets.back();
+      }
+      const HideSet* hideset_union(const HideSet* a, const HideSet* b) {
+	 if (!a || a == b) return b;
+	 if (!b) return a;
+	 const HideSet* result = b;
+	 for (; a; a = a->next) {
+	    if (!hidden(b, a->name)) result = hideset_add(result, a->name);
+	 }
+	 return result;
+      }
+      const HideSet* hideset_intersection(const HideSet* a,
+	    const HideSet* b) {
+	 const HideSet* result = nullptr;
+	 for (; a; a = a->next) {
+	    if (hidden(b, a->name)) result = hideset_add(result, a->name);
+	 }
+	 return result;
+      }
+
+      Token new_token(TokenKind kind, const std::string& text,
+	    const Token& origin) {
+	 texts.push_back(text);
+	 Token token = origin;
+	 token.kind = kind;
+	 token.text = texts.back().data();
+	 token.len = texts.back().size();
+	 token.name = kind == IDENTIFIER? intern_name(text): nullptr;
+	 token.hideset = nullptr;
+	 return token;
+      }
+      Token number_token(unsigned long value, const Token& origin) {
+	 return new_token(NUMBER, std::to_string(value), origin);
+      }
+
+      /* prepare a list of tokens to be read until END_OF_LIST */
+      void push_list(const std::vector<Token>& tokens) {
+	 Token end = {};
+	 end.kind = END_OF_LIST;
+	 end.text = "";
+	 pending.push_back(end);
+	 for (auto it = tokens.rbegin(); it != tokens.rend(); ++it) {
+	    pending.push_back(*it);
+	 }
+      }
+
+      /* complete macro expansion of a separate list of tokens */
+      std::vector<Token> expand_list(const std::vector<Token>& tokens) {
+	 push_list(tokens);
+	 std::vector<Token> result;
+	 for(;;) {
+	    Token token = read();
+	    if (token.kind == END_OF_LIST) break;
+	    if (!expand(token)) result.push_back(token);
+	 }
+	 return result;
+      }
+
+      /* the tokens of an expansion replace the invocation
+	 and are rescanned together with the rest of the input */
+      void push_expansion(std::vector<Token>& tokens,
+	    const HideSet* hideset, const Token& origin) {
+	 for (auto& token: tokens) {
+	    token.hideset = hideset_union(token.hideset, hideset);
+	    token.line = origin.line; token.column = origin.column;
+	    token.bol = false; token.expanded = true;
+	 }
+	 if (!tokens.empty()) tokens.front().space = origin.space;
+	 for (auto it = tokens.rbegin(); it != tokens.rend(); ++it) {
+	    pending.push_back(*it);
+	 }
+      }
+
+      /* expand the given token if it invokes a macro;
+	 the expansion is pushed back onto the input */
+      bool expand(const Token& token) {
+	 if (token.kind != IDENTIFIER) return false;
+	 auto it = macros.find(token.name);
+	 if (it == macros.end() || hidden(token.hideset, token.name)) {
+	    return false;
+	 }
+	 /* the macro may be undefined by directives among its arguments */
+	 std::shared_ptr<const Macro> macro = it->second;
+	 if (macro->kind != REGULAR_MACRO) {
+	    Token result = special_token(*macro, token);
+	    result.expanded = true;
+	    pending.push_back(result);
+	    return true;
+	 }
+	 std::vector<Token> tokens;
+	 std::vector<std::vector<Token>> args;
+	 if (!macro->function_like) {
+	    subst(*macro, 0, macro->body.size(), args, tokens);
+	    push_expansion(tokens, hideset_add(token.hideset, token.name),
+	       token);
+	    return true;
+	 }
+	 Token next = read();
+	 if (!next.is('(')) {
+	    pending.push_back(next);
+	    return false;
+	 }
+	 Token rparen;
+	 if (!collect_args(*macro, token, args, rparen)) return false;
+	 subst(*macro, 0, macro->body.size(), args, tokens);
+	 push_expansion(tokens, hideset_add(hideset_intersection(
+	    token.hideset, rparen.hideset), token.name), token);
+	 return true;
+      }
+
+      /* collect the arguments of the invocation of a function-like
+	 macro following the opening parenthesis */
+      bool collect_args(const Macro& macro, const Token& origin,
+	    std::vector<std::vector<Token>>& args, Token& rparen) {
+	 args.emplace_back();
+	 int depth = 0;
+	 for(;;) {
+	    Token token = read();
+	    if (token.kind == END_OF_FILE || token.kind == END_OF_LIST) {
+	       error(origin, "unterminated argument list invoking macro \"" +
+		  *origin.name + "\"");
+	       pending.push_back(token);
+	       return false;
+	    }
+	    if (token.is('(')) {
+	       ++depth;
+	    } else if (token.is(')')) {
+	       if (depth == 0) {
+		  rparen = token; break;
+	       }
+	       --depth;
+	    } else if (token.is(',') && depth == 0 &&
+		  !(macro.variadic && args.size() == macro.params.size())) {
+	       args.emplace_back();
+	       continue;
+	    }
+	    args.back().push_back(token);
+	 }
+	 if (macro.params.empty() && args.size() == 1 && args[0].empty()) {
+	    args.clear();
+	 }
+	 if (macro.variadic && args.size() + 1 == macro.params.size()) {
+	    /* the variable arguments may be omitted */
+	    args.emplace_back();
+	 }
+	 if (args.size() != macro.params.size()) {
+	    std::ostringstream os;
+	    os << "macro \"" << *origin.name << "\" requires " <<
+	       macro.params.size() << " arguments, but " <<
+	       args.size() << " given";
+	    error(origin, os.str());
+	    return false;
+	 }
+	 return true;
+      }
+
+      int param_index(const Macro& macro, const Token& token) const {
+	 if (token.kind != IDENTIFIER) return -1;
+	 for (std::size_t i = 0; i < macro.params.size(); ++i) {
+	    if (macro.params[i] == token.name) return i;
+	 }
+	 return -1;
+      }
+
+      /* substitute the body of a macro in the range [begin, end)
+	 with the given arguments, see 6.10.3.1 to 6.10.3.3 */
+      void subst(const Macro& macro, std::size_t begin, std::size_t end,
+	    const std::vector<std::vector<Token>>& args,
+	    std::vector<Token>& out) {
+	 /* arguments are fully expanded on demand, at most once */
+	 std::vector<std::unique_ptr<std::vector<Token>>>
+	    expanded(args.size());
+	 auto get_expanded = [&](int i) -> const std::vector<Token>& {
+	    if (!expanded[i]) {
+	       expanded[i] = std::make_unique<std::vector<Token>>(
+		  expand_list(args[i]));
+	    }
+	    return *expanded[i];
+	 };
+	 const std::vector<Token>& body = macro.body;
+	 int variadic = macro.variadic? int(macro.params.size()) - 1: -1;
+	 for (std::size_t i = begin; i < end; ++i) {
+	    const Token& token = body[i];
+	    int param;
+	    if (macro.function_like && token.is_hash() && i + 1 < end &&
+		  (param = param_index(macro, body[i+1])) >= 0) {
+	       out.push_back(stringize(args[param], token));
+	       ++i; continue;
+	    }
+	    if (token.is_paste() && i + 1 < end) {
+	       const Token& right = body[++i];
+	       param = param_index(macro, right);
+	       if (param < 0) {
+		  paste(out, right);
+		  continue;
+	       }
+	       const std::vector<Token>& arg = args[param];
+	       if (param == variadic && !out.empty() && out.back().is(',')) {
+		  /* GNU extension: , ## __VA_ARGS__ drops the comma
+		     if no variable arguments are given */
+		  if (arg.empty()) {
+		     out.pop_back();
+		  } else {
+		     out.insert(out.end(), arg.begin(), arg.end());
+		  }
+		  continue;
+	       }
+	       if (arg.empty()) continue;
+	       paste(out, arg.front());
+	       out.insert(out.end(), arg.begin() + 1, arg.end());
+	       continue;
+	    }
+	    if (variadic >= 0 && token.kind == IDENTIFIER &&
+		  token.name == name_va_opt && i + 1 < end &&
+		  body[i+1].is('(')) {
+	       std::size_t close = i + 2;
+	       for (int depth = 0; close < end; ++close) {
+		  if (body[close].is('(')) ++depth;
+		  if (body[close].is(')') && depth-- == 0) break;
+	       }
+	       if (!get_expanded(variadic).empty()) {
+		  subst(macro, i + 2, close, args, out);
+	       }
+	       i = close; continue;
+	    }
+	    param = param_index(macro, token);
+	    if (param < 0) {
+	       out.push_back(token);
+	       continue;
+	    }
+	    if (i + 1 < end && body[i+1].is_paste()) {
+	       /* operands of ## are not expanded */
+	       const std::vector<Token>& arg = args[param];
+	       if (!arg.empty()) {
+		  out.insert(out.end(), arg.begin(), arg.end());
+		  continue;
+	       }
+	       /* placemarker */
+	       i += 2;
+	       if (i >= end) break;
+	       int right = param_index(macro, body[i]);
+	       if (right >= 0) {
+		  out.insert(out.end(), args[right].begin(),
+		     args[right].end());
+	       } else {
+		  out.push_back(body[i]);
+	       }
+	       continue;
+	    }
+	    const std::vector<Token>& arg = get_expanded(param);
+	    std::size_t first = out.size();
+	    out.insert(out.end(), arg.begin(), arg.end());
+	    if (out.size() > first) out[first].space = token.space;
+	 }
+      }
+
+      Token stringize(const std::vector<Token>& arg, const Token& origin) {
+	 std::string text = "\"";
+	 for (std::size_t i = 0; i < arg.size(); ++i) {
+	    const Token& token = arg[i];
+	    if (i > 0 && token.space) text += ' ';
+	    if (token.kind == STRING || token.kind == CHARACTER) {
+	       for (std::size_t j = 0; j < token.len; ++j) {
+		  char ch = token.text[j];
+		  if (ch == '"' || ch == '\\') text += '\\';
+		  text += ch;
+	       }
+	    } else {
+	       text.append(token.text, token.len);
+	    }
+	 }
+	 text += '"';
+	 Token token = new_token(STRING, text, origin);
+	 token.space = origin.space;
+	 return token;
+      }
+
+      /* paste the last token of out with the given token */
+      void paste(std::vector<Token>& out, const Token& right) {
+	 if (out.empty()) {
+	    out.push_back(right);
+	    return;
+	 }
+	 Token& left = out.back();
+	 std::string text = left.spelling() + right.spelling();
+	 TokenKind kind;
+	 if (lex_token(text.data(), text.data() + text.size(), kind) !=
+	       text.data() + text.size()) {
+	    error(left, "pasting \"" + left.spelling() + "\" and \"" +
+	       right.spelling() +
+	       "\" does not give a valid preprocessing token");
+	    out.push_back(right);
+	    return;
+	 }
+	 Token token = new_token(kind, text, left);
+	 token.hideset = left.hideset;
+	 left = token;
+      }
+
+      Token special_token(const Macro& macro, const Token& origin) {
+	 const Frame& frame = frames.back();
+	 switch (macro.kind) {
+	    case FILE_MACRO:
+	       return new_token(STRING, quote(*frame.name), origin);
+	    case BASE_FILE_MACRO:
+	       return new_token(STRING, quote(input_file), origin);
+	    case LINE_MACRO:
+	       return number_token(origin.line + frame.line_delta, origin);
+	    case COUNTER_MACRO:
+	       return number_token(counter++, origin);
+	    case INCLUDE_LEVEL_MACRO:
+	       return number_token(frames.size() - 1, origin);
+	    case DATE_MACRO:
+	       return new_token(STRING, preprocessor.date, origin);
+	    case TIME_MACRO:
+	       return new_token(STRING, preprocessor.time, origin);
+	    default:
+	       assert(false); return origin;
+	 }
+      }
+};
+
+// constructor ===============================================================
+
+Preprocessor::Preprocessor(const std::string& cpp_path) :
+      cpp_path(cpp_path) {
+   std::time_t now = std::time(nullptr);
+   struct tm tm;
+   localtime_r(&now, &tm);
+   char buf[32];
+   std::strftime(buf, sizeof buf, "\"%b %e %Y\"", &tm);
+   date = buf;
+   std::strftime(buf, sizeof buf, "\"%H:%M:%S\"", &tm);
+   time = buf;
+}
+
+Preprocessor::~Preprocessor() {
+}
+
+// accessors =================================================================
+
+std::string Preprocessor::preprocess(const Args& args,
+      const std::string& input_file, bool& success) const {
+   auto config = get_configuration(args);
+   Unit unit(*this, *config, input_file);
+   return unit.run(success);
+}
+
+// private accessors =========================================================
+
+std::shared_ptr<const Preprocessor::Configuration>
+      Preprocessor::get_configuration(const Args& args) const {
+   std::lock_guard<std::mutex> lock(config_mutex);
+   auto it = configurations.find(args);
+   if (it != configurations.end()) return it->second;
+
+   auto config = std::make_shared<Configuration>();
+   /* -include is handled by us, dependency output is not wanted */
+   Args query_args;
+   for (std::size_t i = 0; i < args.size(); ++i) {
+      const std::string& arg = args[i];
+      if (arg == "-include" && i + 1 < args.size()) {
+	 config->includes.push_back(args[++i]);
+      } else if ((arg == "-MF" || arg == "-MT" || arg == "-MQ") &&
+	    i + 1 < args.size()) {
+	 ++i;
+      } else if (arg.compare(0, 2, "-M") != 0) {
+	 query_args.push_back(arg);
+      }
+   }
+
+   /* search path as listed by -v on standard error */
+   Args search_args(query_args);
+   search_args.push_back("-v");
+   std::istringstream diagnostics(
+      query_preprocessor(cpp_path, search_args, true));
+   std::string line;
+   bool listing = false;
+   config->bracket_start = std::string::npos;
+   while (std::getline(diagnostics, line)) {
+      if (line.compare(0, 9, "#include ") == 0) {
+	 listing = true;
+	 if (line.find('<') != std::string::npos) {
+	    config->bracket_start = config->search.size();
+	 }
+      } else if (line == "End of search list.") {
+	 break;
+      } else if (listing && line.size() > 1 && line[0] == ' ') {
+	 std::string dir = line.substr(1);
+	 std::size_t suffix = dir.find(" (");
+	 if (suffix != std::string::npos) dir.erase(suffix);
+	 config->search.push_back(dir);
+      }
+   }
+   if (config->bracket_start == std::string::npos) {
+      config->bracket_start = config->search.size();
+   }
+
+   /* predefined macros as listed by -dM */
+   Args define_args(query_args);
+   define_args.push_back("-dM");
+   config->builtins = std::make_unique<SourceFile>("<built-in>",
+      query_preprocessor(cpp_path, define_args));
+   const std::vector<Token>& tokens = config->builtins->tokens;
+   for (std::size_t i = 0; tokens[i].kind != END_OF_FILE; ++i) {
+      if (!tokens[i].bol || !tokens[i].is_hash()) continue;
+      std::vector<Token> line = directive_line(tokens, i + 1);
+      if (line.empty() || line[0].name != name_define) continue;
+      const std::string* name;
+      std::string error;
+      auto macro = parse_macro(line, 1, name, error);
+      if (macro) config->macros[name] = macro;
+   }
+   struct {
+      const char* name;
+      MacroKind kind;
+   } specials[] = {
+      {"__FILE__", FILE_MACRO},
+      {"__LINE__", LINE_MACRO},
+      {"__COUNTER__", COUNTER_MACRO},
+      {"__INCLUDE_LEVEL__", INCLUDE_LEVEL_MACRO},
+      {"__BASE_FILE__", BASE_FILE_MACRO},
+      {"__DATE__", DATE_MACRO},
+      {"__TIME__", TIME_MACRO},
+   };
+   for (auto& special: specials) {
+      auto macro = std::make_shared<Macro>();
+      macro->kind = special.kind;
+      macro->function_like = false;
+      macro->variadic = false;
+      config->macros[intern_name(special.name)] = macro;
+   }
+
+   configurations[args] = config;
+   return config;
+}
+
+std::shared_ptr<const Preprocessor::SourceFile>
+      Preprocessor::get_file(const std::string& path) const {
+   {
+      std::lock_guard<std::mutex> lock(files_mutex);
+      auto it = files.find(path);
+      if (it != files.end()) return it->second;
+   }
+   /* files are read and tokenized outside the critical region */
+   std::shared_ptr<const SourceFile> file;
+   struct stat statbuf;
+   if (stat(path.c_str(), &statbuf) == 0 && S_ISREG(statbuf.st_mode)) {
+      try {
+	 file = std::make_shared<SourceFile>(path);
+      } catch (Astl::Exception&) {
+	 file = nullptr;
+      }
+   }
+   std::lock_guard<std::mutex> lock(files_mutex);
+   return files.insert(std::make_pair(path, file)).first->second;
+}
+
+} // namespace AstlC
@@ -0,0 +1,77 @@
+/*
+   Copyright (C) 2026 The Astl-C contributors
+   ----------------------------------------------------------------------------
+   Astl-C is free software; you can redistribute it
+   and/or modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either version
+   2 of the License, or (at your option) any later version.
+
+   Astl-C is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+#ifndef ASTL_C_PREPROCESSOR_H
+#define ASTL_C_PREPROCESSOR_H
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include "pp.hpp"
+
+namespace AstlC {
+
+   /* built-in C preprocessor which avoids running an external
+      preprocessor for each source;
+      the external preprocessor is consulted just once for each
+      distinct set of options to learn its search path and its
+      predefined macros; included files are read and tokenized
+      just once and shared by all sources together with the
+      knowledge about their include guards;
+      the output follows the syntax of gcc -E but, unlike gcc,
+      the columns of all tokens are preserved unless they
+      are shifted by preceding macro expansions on the same line */
+   class Preprocessor {
+      public:
+	 // constructor
+	 Preprocessor(const std::string& cpp_path);
+	 ~Preprocessor();
+
+	 // accessor
+	 /* returns the preprocessed source;
+	    errors are reported on standard error and cause
+	    success to be set to false;
+	    this may be invoked by multiple threads in parallel */
+	 std::string preprocess(const Args& args,
+	    const std::string& input_file, bool& success) const;
+
+      private:
+	 struct SourceFile;
+	 struct Configuration;
+	 class Unit;
+
+	 std::string cpp_path;
+	 std::string date, time; // for __DATE__ and __TIME__
+	 mutable std::mutex config_mutex;
+	 mutable std::map<Args, std::shared_ptr<const Configuration>>
+	    configurations;
+	 mutable std::mutex files_mutex;
+	 /* null pointers represent files which cannot be read */
+	 mutable std::map<std::string, std::shared_ptr<const SourceFile>>
+	    files;
+
+	 std::shared_ptr<const Configuration> get_configuration(
+	    const Args& args) const;
+	 std::shared_ptr<const SourceFile> get_file(
+	    const std::string& path) const;
+   };
+
+} // namespace AstlC
+
+#endif
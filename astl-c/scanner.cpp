@@ -17,6 +17,7 @@
 */
 
 #include <cassert>
+#include <chrono>
 #include <cwchar>
 #include <locale>
 #include <memory>
@@ -24,6 +25,7 @@
 #include <astl/token.hpp>
 #include <astl/utf8.hpp>
 #include "error.hpp"
+#include "filenames.hpp"
 #include "keywords.hpp"
 #include "location.hpp"
 #include "scanner.hpp"
@@ -61,15 +63,77 @@ bool is_whitespace(char ch) {
 
 Scanner::Scanner(std::istream& in, const std::string& input_name,
       SymTable& symtab) :
-      in(in), input_name(input_name), ch(0), eof(false),
-      tokenstr(nullptr), symtab(symtab) {
-   pos.initialize(&this->input_name);
+      input(std::make_unique<SourceBuffer>(in)),
+      cp(input->begin()), end(input->end()), locale(in.getloc()),
+      input_name(input_name), ch(0), eof(false),
+      tokenstart(nullptr), tokenstr(nullptr), symtab(symtab),
+      arena(nullptr), tokens(0), timed(false), scan_time(0) {
+   pos.initialize(intern_filename(input_name));
    nextch();
 }
 
-// mutator ===================================================================
+Scanner::Scanner(const SourceBuffer& source, const std::string& input_name,
+      SymTable& symtab, const std::locale& locale, NodeArena* arena) :
+      Scanner(source.begin(), source.end(), input_name, symtab,
+	 locale, arena) {
+}
+
+Scanner::Scanner(const char* begin, const char* end,
+      const std::string& input_name, SymTable& symtab,
+      const std::locale& locale, NodeArena* arena) :
+      cp(begin), end(end), locale(locale),
+      input_name(input_name), ch(0), eof(false),
+      tokenstart(nullptr), tokenstr(nullptr), symtab(symtab),
+      arena(arena), tokens(0), timed(false), scan_time(0) {
+   pos.initialize(intern_filename(input_name));
+   nextch();
+}
+
+// accessors =================================================================
+
+NodeArena* Scanner::get_arena() const {
+   return arena;
+}
+
+std::size_t Scanner::get_token_count() const {
+   return tokens;
+}
+
+double Scanner::get_scan_time() const {
+   return std::chrono::duration<double>(scan_time).count();
+}
+
+const location& Scanner::get_origin() const {
+   return origin;
+}
 
+// mutators ==================================================================
+
+/* the end of the input (token 0) is not counted */
 int Scanner::get_token(semantic_type& yylval, location& yylloc) {
+   int token;
+   if (timed) {
+      auto start = std::chrono::steady_clock::now();
+      token = next_token(yylval, yylloc);
+      scan_time += std::chrono::steady_clock::now() - start;
+   } else {
+      token = next_token(yylval, yylloc);
+   }
+   if (token != 0) ++tokens;
+   return token;
+}
+
+void Scanner::enable_timing() {
+   timed = true;
+}
+
+void Scanner::set_origin(const position& end) {
+   origin = location(end);
+}
+
+// private methods ===========================================================
+
+int Scanner::next_token(semantic_type& yylval, location& yylloc) {
    int token = 0;
    yylval = NodePtr(nullptr);
 
@@ -85,46 +149,40 @@ restart:
    }
    tokenloc.begin = oldpos;
    if (is_letter(ch)) {
-      tokenstr = std::make_unique<std::string>();
+      tokenstart = current();
       bool char_or_string_const_possible = ch == 'L';
       nextch();
       if (char_or_string_const_possible && ch == '\'') {
-	 parse_character_constant(); convert_to_utf8();
+	 parse_character_constant(); fetch_tokenstr(); convert_to_utf8();
 	 token = parser::token::CHAR_CONSTANT;
       } else if (char_or_string_const_possible && ch == '"') {
-	 parse_string_constant(); convert_to_utf8();
+	 parse_string_constant(); fetch_tokenstr(); convert_to_utf8();
 	 token = parser::token::STRING_LITERAL;
       } else {
 	 while (is_letter(ch) || is_digit(ch)) {
 	    nextch();
 	 }
+	 /* keywords and identifiers are classified in place,
+	    a semantic value is required for identifiers only */
 	 int keyword_token;
-	 if (keyword_table.lookup(*tokenstr, keyword_token)) {
+	 SymbolClass sc;
+	 if (keyword_table.lookup(tokenstart, current(), keyword_token)) {
 	    token = keyword_token;
-	    /* a semantic value is no longer required for keywords */
-	    tokenstr = nullptr;
+	 } else if (symtab.lookup(tokenstart, current(), sc) &&
+	       sc == SC_TYPE) {
+	    token = parser::token::TYPE_IDENT;
+	    fetch_tokenstr();
 	 } else {
-	    Symbol symbol;
-	    if (symtab.lookup(*tokenstr, symbol)) {
-	       switch (symbol.get_class()) {
-		  case SC_TYPE:
-		     token = parser::token::TYPE_IDENT;
-		     break;
-		  default:
-		     token = parser::token::IDENT;
-		     break;
-	       }
-	    } else {
-	       token = parser::token::IDENT;
-	    }
+	    token = parser::token::IDENT;
+	    fetch_tokenstr();
 	 }
       }
       if (tokenstr != nullptr) {
-	 yylval = std::make_shared<Node>(make_loc(tokenloc),
+	 yylval = make_node(arena, make_loc(tokenloc),
 	    Token(token, std::move(tokenstr)));
       }
    } else if (is_digit(ch)) {
-      tokenstr = std::make_unique<std::string>();
+      tokenstart = current();
       enum {OCTAL, DECIMAL, HEXADECIMAL} repr;
       bool octal_to_float = false;
       if (ch == '0') {
@@ -222,6 +280,7 @@ restart:
 	 // which did not turn into a decimal floating constant
 	 error("invalid octal constant");
       }
+      fetch_tokenstr();
       if (!token) {
 	 switch (repr) {
 	    case OCTAL:
@@ -235,7 +294,7 @@ restart:
 	       break;
 	 }
       }
-      yylval = std::make_shared<Node>(make_loc(tokenloc),
+      yylval = make_node(arena, make_loc(tokenloc),
 	 Token(token, std::move(tokenstr)));
    } else {
       switch (ch) {
@@ -272,28 +331,28 @@ restart:
 	    }
 	    goto restart;
 	 case '\'':
-	    tokenstr = std::make_unique<std::string>();
-	    parse_character_constant(); convert_to_utf8();
+	    tokenstart = current();
+	    parse_character_constant(); fetch_tokenstr(); convert_to_utf8();
 	    token = parser::token::CHAR_CONSTANT;
-	    yylval = std::make_shared<Node>(make_loc(tokenloc),
+	    yylval = make_node(arena, make_loc(tokenloc),
 	       Token(token, std::move(tokenstr)));
 	    break;
 	 case '"':
-	    tokenstr = std::make_unique<std::string>();
-	    parse_string_constant(); convert_to_utf8();
+	    tokenstart = current();
+	    parse_string_constant(); fetch_tokenstr(); convert_to_utf8();
 	    token = parser::token::STRING_LITERAL;
-	    yylval = std::make_shared<Node>(make_loc(tokenloc),
+	    yylval = make_node(arena, make_loc(tokenloc),
 	       Token(token, std::move(tokenstr)));
 	    break;
 	 case '.':
 	    nextch();
 	    if (is_digit(ch)) {
-	       tokenstr = std::make_unique<std::string>();
-	       *tokenstr += '.';
+	       tokenstart = current() - 1; // include the preceding '.'
 	       /* decimal floating constant */
 	       parse_decimal_floating_constant();
+	       fetch_tokenstr();
 	       token = parser::token::DECIMAL_FLOATING_CONSTANT;
-	       yylval = std::make_shared<Node>(make_loc(tokenloc),
+	       yylval = make_node(arena, make_loc(tokenloc),
 		  Token(token, std::move(tokenstr)));
 	    } else if (ch == '.') {
 	       nextch();
@@ -493,10 +552,8 @@ restart:
    return token;
 }
 
-// private methods ===========================================================
-
 /*
- * get next character from the input stream, if available;
+ * get next character from the input buffer, if available;
  * pos gets updated
  */
 void Scanner::nextch() {
@@ -505,14 +562,10 @@ void Scanner::nextch() {
    if (eof) {
       ch = 0; return;
    }
-   if (tokenstr != nullptr) {
-      *tokenstr += ch;
-   }
-   char c;
-   if (!in.get(c)) {
+   if (cp == end) {
       eof = true; ch = 0; return;
    }
-   ch = c;
+   ch = *cp++;
    if (ch == '\n') {
       pos.lines();
    } else if (ch == '\t') {
@@ -523,6 +576,21 @@ void Scanner::nextch() {
    }
 }
 
+/* position of ch within the input buffer */
+const char* Scanner::current() const {
+   if (eof) {
+      return end;
+   } else {
+      return cp - 1;
+   }
+}
+
+/* take the text of the current token which ranges
+   from tokenstart up to but not including ch */
+void Scanner::fetch_tokenstr() {
+   tokenstr = std::make_unique<std::string>(tokenstart, current());
+}
+
 void Scanner::parse_decimal_floating_constant() {
    // we are at a '.', a digit behind the '.', at 'e' or 'E'
    if (ch != 'e' && ch != 'E') {
@@ -693,18 +761,23 @@ void Scanner::parse_directive() {
       if (ch == '"') {
 	 // extract pathname
 	 nextch();
-	 tokenstr = std::make_unique<std::string>();
+	 tokenstart = current();
 	 while (!eof && ch != '"' && ch != '\n') {
 	    nextch();
 	 }
 	 if (eof || ch == '\n') {
 	    error("broken linemarker in cpp output");
 	 }
-	 // FIXME: the class position generated by bison
-	 // never releases the filename; to reduce
-	 // unnecessary memory consumption, we should maintain
-	 // a cache of filenames associated with the scanner object
-	 std::string* filename = tokenstr.release();
+	 // the class position generated by bison never releases
+	 // the filename, so all filenames are interned;
+	 // linemarkers mostly repeat the current filename
+	 const char* filename_end = current();
+	 std::size_t len = filename_end - tokenstart;
+	 const std::string* filename = pos.filename;
+	 if (!filename || filename->size() != len ||
+	       filename->compare(0, len, tokenstart, len) != 0) {
+	    filename = intern_filename(tokenstart, filename_end);
+	 }
 	 // skip flags (1 = push, 2 = pop, 3 = system header,
 	 // 4 = requires extern "C") as they do not concern us
 	 while (!eof && ch != '\n') {
@@ -749,7 +822,6 @@ void Scanner::convert_to_utf8() {
 	    using the the corresponding facet of the locale
 	    of the input stream */
 	 using codecvt = std::codecvt<char32_t, char, std::mbstate_t>;
-	 auto locale = in.getloc();
 	 if (std::has_facet<codecvt>(locale)) {
 	    auto& facet = std::use_facet<codecvt>(locale);
 	    std::u32string str32(tokenstr->size(), U'\0');
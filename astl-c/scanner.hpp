@@ -19,8 +19,13 @@
 #ifndef ASTL_C_SCANNER_H
 #define ASTL_C_SCANNER_H
 
+#include <chrono>
+#include <cstddef>
 #include <iostream>
+#include <locale>
 #include <memory>
+#include "arena.hpp"
+#include "buffer.hpp"
 #include "parser.hpp"
 #include "symtable.hpp"
 #include "location.hpp"
@@ -33,23 +38,58 @@ namespace AstlC {
       public:
 	 Scanner(std::istream& in, const std::string& input_name,
 	    SymTable& symtab);
+	 /* the source buffer must survive the scanner;
+	    if an arena is given, all nodes are allocated from it */
+	 Scanner(const SourceBuffer& source, const std::string& input_name,
+	    SymTable& symtab, const std::locale& locale = std::locale(),
+	    NodeArena* arena = nullptr);
+	 /* scans just [begin, end) which must start at the beginning
+	    of a line */
+	 Scanner(const char* begin, const char* end,
+	    const std::string& input_name, SymTable& symtab,
+	    const std::locale& locale = std::locale(),
+	    NodeArena* arena = nullptr);
+
+	 // accessors
+	 NodeArena* get_arena() const;
+	 std::size_t get_token_count() const;
+	 /* time spent in get_token, if timing is enabled */
+	 double get_scan_time() const;
+	 /* initial location for the parser */
+	 const location& get_origin() const;
 
 	 // mutators
 	 int get_token(semantic_type& yylval, location& yylloc);
+	 void enable_timing();
+	 /* set the origin to the end of the text which preceded
+	    the scanned range */
+	 void set_origin(const position& end);
 
       private:
-	 std::istream& in;
+	 std::unique_ptr<SourceBuffer> input; // if owned by the scanner
+	 const char* cp; // next character to be fetched by nextch()
+	 const char* end; // end of input
+	 std::locale locale; // encoding of the input
 	 std::string input_name;
 	 unsigned char ch;
 	 bool eof;
 	 int lasttoken; // last token returned by get_token()
 	 position oldpos, pos;
 	 location tokenloc;
+	 location origin; // see set_origin
+	 const char* tokenstart; // beginning of the text of the current token
 	 std::unique_ptr<std::string> tokenstr;
 	 SymTable& symtab;
+	 NodeArena* arena; // optional
+	 std::size_t tokens; // number of tokens delivered so far
+	 bool timed;
+	 std::chrono::steady_clock::duration scan_time;
 
 	 // private mutators
+	 int next_token(semantic_type& yylval, location& yylloc);
 	 void nextch();
+	 const char* current() const;
+	 void fetch_tokenstr();
 	 void error(char const* msg);
 	 void parse_decimal_floating_constant();
 	 void parse_hexadecimal_floating_constant();
@@ -0,0 +1,241 @@
+/*
+   Copyright (C) 2026 The Astl-C contributors
+   ----------------------------------------------------------------------------
+   Astl-C is free software; you can redistribute it
+   and/or modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either version
+   2 of the License, or (at your option) any later version.
+
+   Astl-C is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+#include <sys/resource.h>
+#include <ctime>
+#include <iomanip>
+#include "stats.hpp"
+
+namespace AstlC {
+
+// private functions =========================================================
+
+static double get_thread_cpu_time() {
+   struct timespec ts;
+   if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) < 0) return 0;
+   return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static double seconds(const struct timeval& tv) {
+   return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+static double get_cpu_time(int who) {
+   struct rusage usage;
+   if (getrusage(who, &usage) < 0) return 0;
+   return seconds(usage.ru_utime) + seconds(usage.ru_stime);
+}
+
+static double since(std::chrono::steady_clock::time_point start) {
+   return std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+}
+
+static void print_json_string(std::ostream& out, const std::string& s) {
+   out << '"';
+   for (char ch: s) {
+      switch (ch) {
+	 case '"': out << "\\\""; break;
+	 case '\\': out << "\\\\"; break;
+	 case '\n': out << "\\n"; break;
+	 case '\t': out << "\\t"; break;
+	 default:
+	    if (static_cast<unsigned char>(ch) < 0x20) {
+	       out << "\\u" << std::hex << std::setw(4) <<
+		  std::setfill('0') << static_cast<int>(ch) <<
+		  std::dec << std::setfill(' ');
+	    } else {
+	       out << ch;
+	    }
+	    break;
+      }
+   }
+   out << '"';
+}
+
+static void print_json_fields(std::ostream& out, const SourceStats& s) {
+   out << "\"cached\": " << (s.cached? "true": "false") <<
+      ", \"cpp_bytes\": " << s.cpp_bytes <<
+      ", \"tokens\": " << s.tokens <<
+      ", \"nodes\": " << s.nodes <<
+      ", \"preprocess_time\": " << s.preprocess_time <<
+      ", \"preprocess_cpu_time\": " << s.preprocess_cpu_time <<
+      ", \"scan_time\": " << s.scan_time <<
+      ", \"parse_time\": " << s.parse_time <<
+      ", \"parse_cpu_time\": " << s.parse_cpu_time;
+}
+
+static void print_fields(std::ostream& out, const SourceStats& s) {
+   if (s.cached) {
+      out << "   taken from the syntax tree cache, " <<
+	 s.nodes << " nodes" << std::endl;
+      return;
+   }
+   out << "   preprocessing: " << s.preprocess_time << "s (CPU " <<
+      s.preprocess_cpu_time << "s), " << s.cpp_bytes << " bytes" <<
+      std::endl;
+   out << "   parsing: " << s.parse_time << "s (CPU " <<
+      s.parse_cpu_time << "s), including scanning: " <<
+      s.scan_time << "s" << std::endl;
+   out << "   " << s.tokens << " tokens, " <<
+      s.nodes << " nodes" << std::endl;
+}
+
+// Stopwatch =================================================================
+
+Stopwatch::Stopwatch() :
+      start(std::chrono::steady_clock::now()),
+      start_cpu(get_thread_cpu_time()) {
+}
+
+double Stopwatch::get_wall_time() const {
+   return since(start);
+}
+
+double Stopwatch::get_cpu_time() const {
+   return get_thread_cpu_time() - start_cpu;
+}
+
+// constructor ===============================================================
+
+Stats::Stats() :
+      start(std::chrono::steady_clock::now()),
+      start_cpu(get_cpu_time(RUSAGE_SELF)),
+      generate_start(start), generate_start_cpu(start_cpu),
+      generate_time(0), generate_cpu_time(0),
+      script_time(0), script_cpu_time(0),
+      cpp_cpu_time(0), peak_rss(0) {
+}
+
+// accessors =================================================================
+
+void Stats::print(std::ostream& out) const {
+   auto flags = out.flags();
+   auto precision = out.precision();
+   out << std::fixed << std::setprecision(3);
+   for (auto& source: sources) {
+      out << "astl-c: " << source.name << ":" << std::endl;
+      print_fields(out, source.stats);
+   }
+   out << "astl-c: total:" << std::endl;
+   print_fields(out, get_total());
+   out << "   generating syntax trees: " << generate_time <<
+      "s (CPU " << generate_cpu_time << "s, preprocessors " <<
+      cpp_cpu_time << "s)" << std::endl;
+   out << "   script execution: " << script_time <<
+      "s (CPU " << script_cpu_time << "s)" << std::endl;
+   out << "   peak RSS: " << peak_rss << " kB" << std::endl;
+   out.flags(flags); out.precision(precision);
+}
+
+void Stats::print_json(std::ostream& out) const {
+   auto flags = out.flags();
+   auto precision = out.precision();
+   out << std::fixed << std::setprecision(6);
+   out << "{" << std::endl << "  \"sources\": [";
+   bool first = true;
+   for (auto& source: sources) {
+      if (!first) out << ",";
+      first = false;
+      out << std::endl << "    {\"name\": ";
+      print_json_string(out, source.name);
+      out << ", ";
+      print_json_fields(out, source.stats);
+      out << "}";
+   }
+   out << std::endl << "  ]," << std::endl << "  \"total\": {";
+   print_json_fields(out, get_total());
+   out << "," << std::endl <<
+      "    \"generate_time\": " << generate_time <<
+      ", \"generate_cpu_time\": " << generate_cpu_time <<
+      ", \"cpp_cpu_time\": " << cpp_cpu_time <<
+      ", \"script_time\": " << script_time <<
+      ", \"script_cpu_time\": " << script_cpu_time <<
+      ", \"peak_rss_kb\": " << peak_rss << "}" << std::endl;
+   out << "}" << std::endl;
+   out.flags(flags); out.precision(precision);
+}
+
+// mutators ==================================================================
+
+void Stats::add(const std::string& source_name, const SourceStats& stats) {
+   sources.push_back(Source{source_name, stats});
+}
+
+void Stats::generating() {
+   generate_start = std::chrono::steady_clock::now();
+   generate_start_cpu = get_cpu_time(RUSAGE_SELF);
+}
+
+void Stats::generated() {
+   generate_time += since(generate_start);
+   generate_cpu_time += get_cpu_time(RUSAGE_SELF) - generate_start_cpu;
+}
+
+void Stats::finish() {
+   script_time = since(start) - generate_time;
+   script_cpu_time = get_cpu_time(RUSAGE_SELF) - start_cpu -
+      generate_cpu_time;
+   cpp_cpu_time = get_cpu_time(RUSAGE_CHILDREN);
+   struct rusage usage;
+   if (getrusage(RUSAGE_SELF, &usage) == 0) {
+      peak_rss = usage.ru_maxrss;
+   }
+}
+
+// private accessor ==========================================================
+
+SourceStats Stats::get_total() const {
+   SourceStats total;
+   total.cached = !sources.empty();
+   for (auto& source: sources) {
+      const SourceStats& s = source.stats;
+      if (!s.cached) total.cached = false;
+      total.cpp_bytes += s.cpp_bytes;
+      total.tokens += s.tokens;
+      total.nodes += s.nodes;
+      total.preprocess_time += s.preprocess_time;
+      total.preprocess_cpu_time += s.preprocess_cpu_time;
+      total.scan_time += s.scan_time;
+      total.parse_time += s.parse_time;
+      total.parse_cpu_time += s.parse_cpu_time;
+   }
+   return total;
+}
+
+// functions =================================================================
+
+/* count all nodes of a syntax tree without recursion */
+std::size_t count_nodes(const Astl::NodePtr& root) {
+   std::size_t count = 0;
+   std::vector<Astl::NodePtr> stack;
+   stack.push_back(root);
+   while (!stack.empty()) {
+      Astl::NodePtr node = stack.back(); stack.pop_back();
+      if (!node) continue;
+      ++count;
+      if (!node->is_leaf()) {
+	 for (std::size_t i = 0; i < node->size(); ++i) {
+	    stack.push_back(node->get_operand(i));
+	 }
+      }
+   }
+   return count;
+}
+
+} // namespace AstlC
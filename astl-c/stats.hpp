@@ -0,0 +1,99 @@
+/*
+   Copyright (C) 2026 The Astl-C contributors
+   ----------------------------------------------------------------------------
+   Astl-C is free software; you can redistribute it
+   and/or modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either version
+   2 of the License, or (at your option) any later version.
+
+   Astl-C is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+#ifndef ASTL_C_STATS_H
+#define ASTL_C_STATS_H
+
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <astl/syntax-tree.hpp>
+
+namespace AstlC {
+
+   /* measures the elapsed wall clock time and
+      the CPU time of the calling thread since its construction */
+   class Stopwatch {
+      public:
+	 // constructor
+	 Stopwatch();
+
+	 // accessors
+	 double get_wall_time() const;
+	 double get_cpu_time() const; // must be called by the same thread
+
+      private:
+	 std::chrono::steady_clock::time_point start;
+	 double start_cpu;
+   };
+
+   /* what has been measured for one source; all times in seconds */
+   struct SourceStats {
+      bool cached = false; // syntax tree taken from the AST cache
+      std::size_t cpp_bytes = 0; // size of the preprocessor output
+      std::size_t tokens = 0;
+      std::size_t nodes = 0;
+      double preprocess_time = 0; // wall clock time
+      double preprocess_cpu_time = 0; // of the preprocessor
+      double scan_time = 0; // wall clock time, included in parse_time
+      double parse_time = 0; // wall clock time
+      double parse_cpu_time = 0;
+   };
+
+   /* collects the statistics of a run of astl-c */
+   class Stats {
+      public:
+	 // constructor
+	 Stats(); // starts the measurement
+
+	 // accessors
+	 void print(std::ostream& out) const;
+	 void print_json(std::ostream& out) const;
+
+	 // mutators
+	 void add(const std::string& source_name, const SourceStats& stats);
+	 void generating(); // generation of syntax trees is resumed
+	 void generated(); // syntax trees are complete
+	 void finish(); // script execution is finished
+
+      private:
+	 struct Source {
+	    std::string name;
+	    SourceStats stats;
+	 };
+	 std::vector<Source> sources;
+	 std::chrono::steady_clock::time_point start;
+	 double start_cpu;
+	 /* generation may alternate with script execution */
+	 std::chrono::steady_clock::time_point generate_start;
+	 double generate_start_cpu;
+	 double generate_time, generate_cpu_time;
+	 double script_time, script_cpu_time;
+	 double cpp_cpu_time; // of all preprocessor processes
+	 long peak_rss; // in kbytes
+
+	 SourceStats get_total() const;
+   };
+
+   std::size_t count_nodes(const Astl::NodePtr& root);
+
+} // namespace AstlC
+
+#endif
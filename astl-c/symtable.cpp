@@ -0,0 +1,144 @@
+/*
+   Copyright (C) 2026 The Astl-C contributors
+   ----------------------------------------------------------------------------
+   Astl-C is free software; you can redistribute it
+   and/or modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either version
+   2 of the License, or (at your option) any later version.
+
+   Astl-C is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+#include <cassert>
+#include <cstring>
+#include "symtable.hpp"
+
+namespace AstlC {
+
+// constructor ===============================================================
+
+SymTable::SymTable() : slots(256, nullptr), kept(nullptr), kept_level(0) {
+}
+
+// accessors =================================================================
+
+bool SymTable::lookup(const std::string& name, Symbol& symbol) const {
+   SymbolClass sc;
+   if (!lookup(name.data(), name.data() + name.size(), sc)) return false;
+   symbol = Symbol(sc, name);
+   return true;
+}
+
+bool SymTable::lookup(const char* begin, const char* end,
+      SymbolClass& sc) const {
+   Ident* ident = find(begin, end, hash(begin, end));
+   if (!ident || ident->bindings.empty()) return false;
+   sc = ident->bindings.back().sc;
+   return true;
+}
+
+// mutators ==================================================================
+
+void SymTable::open() {
+   scopes.emplace_back();
+}
+
+void SymTable::close() {
+   assert(!scopes.empty());
+   if (kept && scopes.size() == kept_level) {
+      for (auto ident: scopes.back()) {
+	 kept->push_back(Symbol(ident->bindings.back().sc, ident->name));
+      }
+      kept = nullptr;
+   }
+   for (auto ident: scopes.back()) {
+      ident->bindings.pop_back();
+   }
+   scopes.pop_back();
+}
+
+bool SymTable::insert(const Symbol& symbol) {
+   assert(!scopes.empty());
+   Ident* ident = intern(symbol.get_name());
+   std::size_t level = scopes.size();
+   if (!ident->bindings.empty() && ident->bindings.back().level == level) {
+      /* already declared within this scope */
+      return false;
+   }
+   ident->bindings.push_back(Binding{level, symbol.get_class()});
+   scopes.back().push_back(ident);
+   return true;
+}
+
+void SymTable::keep_next_scope(std::vector<Symbol>& symbols) {
+   kept = &symbols;
+   kept_level = scopes.size() + 1;
+}
+
+// private functions =========================================================
+
+std::size_t SymTable::hash(const char* begin, const char* end) {
+   std::size_t value = 2166136261u;
+   for (const char* cp = begin; cp != end; ++cp) {
+      value ^= static_cast<unsigned char>(*cp);
+      value *= 16777619u;
+   }
+   return value;
+}
+
+SymTable::Ident* SymTable::find(const char* begin, const char* end,
+      std::size_t hashval) const {
+   std::size_t len = end - begin;
+   std::size_t mask = slots.size() - 1;
+   for (std::size_t index = hashval & mask;; index = (index + 1) & mask) {
+      Ident* ident = slots[index];
+      if (!ident) return nullptr;
+      if (ident->hashval == hashval && ident->name.size() == len &&
+	    std::memcmp(ident->name.data(), begin, len) == 0) {
+	 return ident;
+      }
+   }
+}
+
+SymTable::Ident* SymTable::intern(const std::string& name) {
+   const char* begin = name.data(); const char* end = begin + name.size();
+   std::size_t hashval = hash(begin, end);
+   Ident* ident = find(begin, end, hashval);
+   if (ident) return ident;
+   if ((idents.size() + 1) * 2 > slots.size()) {
+      rehash();
+   }
+   idents.push_back(Ident{name, hashval, {}});
+   ident = &idents.back();
+   std::size_t mask = slots.size() - 1;
+   std::size_t index = hashval & mask;
+   while (slots[index]) {
+      index = (index + 1) & mask;
+   }
+   slots[index] = ident;
+   return ident;
+}
+
+/* double the number of slots to keep the load factor below 1/2 */
+void SymTable::rehash() {
+   std::vector<Ident*> old_slots(slots.size() * 2, nullptr);
+   std::swap(slots, old_slots);
+   std::size_t mask = slots.size() - 1;
+   for (auto ident: old_slots) {
+      if (!ident) continue;
+      std::size_t index = ident->hashval & mask;
+      while (slots[index]) {
+	 index = (index + 1) & mask;
+      }
+      slots[index] = ident;
+   }
+}
+
+} // namespace AstlC
@@ -19,49 +19,60 @@
 #ifndef ASTL_C_SYMTABLE_H
 #define ASTL_C_SYMTABLE_H
 
-#include <cassert>
-#include <map>
+#include <cstddef>
+#include <deque>
 #include <string>
-#include "scope.hpp"
+#include <vector>
 #include "symbol.hpp"
 
 namespace AstlC {
 
+   /* all identifiers are interned in one hash table;
+      each of them keeps a stack of its bindings in the open scopes
+      such that the innermost binding is found with a single probe */
    class SymTable {
-      private:
-	 Scope* scope;
-
       public:
 	 // constructors
-	 SymTable() : scope(nullptr) {
-	 }
-	 ~SymTable() {
-	    while (scope) close();
-	 }
+	 SymTable();
+	 SymTable(const SymTable&) = delete;
+	 SymTable& operator=(const SymTable&) = delete;
 
 	 // accessors
-	 bool lookup(const std::string name, Symbol& symbol) const {
-	    if (scope) {
-	       return scope->lookup(name, symbol);
-	    } else {
-	       return false;
-	    }
-	 }
+	 bool lookup(const std::string& name, Symbol& symbol) const;
+	 /* does not allocate anything */
+	 bool lookup(const char* begin, const char* end,
+	    SymbolClass& sc) const;
 
 	 // mutators
-	 void open() {
-	    scope = new Scope(scope);
-	 }
-	 void close() {
-	    assert(scope);
-	    Scope* outer = scope->get_outer();
-	    delete scope;
-	    scope = outer;
-	 }
-	 bool insert(const Symbol& symbol) {
-	    assert(scope);
-	    return scope->insert(symbol);
-	 }
+	 void open();
+	 void close();
+	 bool insert(const Symbol& symbol);
+	 /* the bindings of the next scope to be opened are appended
+	    to symbols when it is closed */
+	 void keep_next_scope(std::vector<Symbol>& symbols);
+
+      private:
+	 struct Binding {
+	    std::size_t level; // nesting level of the scope
+	    SymbolClass sc;
+	 };
+	 struct Ident {
+	    std::string name;
+	    std::size_t hashval;
+	    std::vector<Binding> bindings; // innermost binding last
+	 };
+	 std::deque<Ident> idents; // owns all interned identifiers
+	 std::vector<Ident*> slots; // open addressing, power of 2
+	 /* identifiers bound in each of the open scopes */
+	 std::vector<std::vector<Ident*>> scopes;
+	 std::vector<Symbol>* kept; // see keep_next_scope
+	 std::size_t kept_level;
+
+	 static std::size_t hash(const char* begin, const char* end);
+	 Ident* find(const char* begin, const char* end,
+	    std::size_t hashval) const;
+	 Ident* intern(const std::string& name);
+	 void rehash();
    };
 
 } // namespace
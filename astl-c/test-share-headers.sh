@@ -0,0 +1,52 @@
+#!/bin/sh
+#
+#   Copyright (C) 2026 The Astl-C contributors
+#   ----------------------------------------------------------------------------
+#   Astl-C is free software; you can redistribute it
+#   and/or modify it under the terms of the GNU Library General Public
+#   License as published by the Free Software Foundation; either version
+#   2 of the License, or (at your option) any later version.
+#
+#   Astl-C is distributed in the hope that it will be
+#   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+#   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+#   Library General Public License for more details.
+#
+#   You should have received a copy of the GNU Library General Public
+#   License along with this library; if not, write to the Free Software
+#   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+#
+# Check that --share-headers delivers the same syntax trees: all
+# sources of the examples are preceded by the same system headers
+# and the printed trees are compared with those of a regular run.
+#
+# Usage: test-share-headers.sh [astl-c]
+
+astlc=`cd \`dirname ${1:-./astl-c}\` && pwd`/`basename ${1:-./astl-c}`
+examples=`cd ../examples && pwd`
+tmpdir=`mktemp -d` || exit 1
+trap 'rm -rf $tmpdir' 0
+sources=""
+for source in $examples/*/*.c; do
+   name=`basename \`dirname $source\``-`basename $source`
+   printf '#include <stdio.h>\n#include <stdlib.h>\n#include "%s"\n' \
+      $source >$tmpdir/$name
+   sources="$sources $name"
+done
+
+# print the trees of all sources
+trees() {
+   (cd $tmpdir &&
+      $astlc $examples/syntax-tree/tree.ast "$@" \
+	 --sources-- $sources --sources--)
+}
+
+trees >$tmpdir/regular || { echo "astl-c failed"; exit 1; }
+trees --share-headers >$tmpdir/shared ||
+   { echo "astl-c --share-headers failed"; exit 1; }
+if [ ! -s $tmpdir/regular ] || ! cmp -s $tmpdir/regular $tmpdir/shared
+then
+   echo "--share-headers: syntax trees differ"
+   exit 1
+fi
+echo "--share-headers: ok"
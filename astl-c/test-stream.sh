@@ -0,0 +1,58 @@
+#!/bin/sh
+#
+#   Copyright (C) 2026 The Astl-C contributors
+#   ----------------------------------------------------------------------------
+#   Astl-C is free software; you can redistribute it
+#   and/or modify it under the terms of the GNU Library General Public
+#   License as published by the Free Software Foundation; either version
+#   2 of the License, or (at your option) any later version.
+#
+#   Astl-C is distributed in the hope that it will be
+#   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+#   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+#   Library General Public License for more details.
+#
+#   You should have received a copy of the GNU Library General Public
+#   License along with this library; if not, write to the Free Software
+#   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+#
+# Check that --stream sets up the built-in preprocessor just once:
+# the preprocessor is to be queried for its configuration as often
+# for four sources of the lock example in streaming mode as for
+# one of them alone. As astl-c does not tell failures by its exit
+# code, the printed syntax trees are counted, one per run.
+#
+# Usage: test-stream.sh [astl-c]
+
+astlc=`cd \`dirname ${1:-./astl-c}\` && pwd`/`basename ${1:-./astl-c}`
+tmpdir=`mktemp -d` || exit 1
+trap 'rm -rf $tmpdir' 0
+cat >$tmpdir/cpp <<END
+#!/bin/sh
+echo "\$*" >>$tmpdir/queries
+exec gcc "\$@"
+END
+chmod +x $tmpdir/cpp
+
+# number of preprocessor invocations of an astl-c run
+# which is expected to print the given number of trees
+queries() {
+   expected=$1; shift
+   rm -f $tmpdir/queries
+   (cd ../examples/lock &&
+      $astlc ../syntax-tree/tree.ast --cpp $tmpdir/cpp --builtin-cpp "$@") \
+	 >$tmpdir/trees 2>/dev/null || return 1
+   [ `grep -c "translation_unit[^s]" $tmpdir/trees` -eq $expected ] ||
+      return 1
+   wc -l <$tmpdir/queries
+}
+
+single=`queries 1 locks1.c` || { echo "astl-c failed"; exit 1; }
+streamed=`queries 4 --stream --sources-- locks1.c locks2.c locks3.c \
+   locks4.c --sources--` ||
+   { echo "astl-c --stream failed"; exit 1; }
+if [ "$single" -ne "$streamed" ]; then
+   echo "--stream: $streamed preprocessor queries instead of $single"
+   exit 1
+fi
+echo "--stream: ok"
@@ -17,11 +17,12 @@
 */
 
 #include <cstdlib>
-#include <fstream>
 #include <iostream>
 #include <locale>
 #include <stdexcept>
+#include <astl/exception.hpp>
 #include <astl/token.hpp>
+#include "buffer.hpp"
 #include "location.hpp"
 #include "parser.hpp"
 #include "scanner.hpp"
@@ -48,18 +49,18 @@ int main(int argc, char** argv) {
 
    Scanner* scanner;
    SymTable symtab;
-   ifstream* fin = 0;
+   SourceBuffer* source = nullptr;
    if (argc > 0) {
       char* fname = *argv++; --argc;
-      fin = new ifstream(fname);
-      string filename(fname);
-      if (!*fin) {
-	 cerr << cmdname << ": unable to open " << fname <<
-	    " for reading" << endl;
+      std::string filename(fname);
+      try {
+	 source = new SourceBuffer(filename);
+      } catch (Exception& e) {
+	 cerr << cmdname << ": " << e.what() << endl;
 	 exit(1);
       }
-      if (locale) fin->imbue(*locale);
-      scanner = new Scanner(*fin, filename, symtab);
+      scanner = new Scanner(*source, filename, symtab,
+	 locale? *locale: std::locale());
    } else {
       if (locale) std::cin.imbue(*locale);
       scanner = new Scanner(cin, "stdin", symtab);
@@ -77,5 +78,5 @@ int main(int argc, char** argv) {
       cout << endl;
    }
    delete scanner;
-   if (fin) delete fin;
+   if (source) delete source;
 }
@@ -17,11 +17,12 @@
 */
 
 #include <cstdlib>
-#include <fstream>
 #include <iostream>
 #include <locale>
 #include <stdexcept>
+#include <astl/exception.hpp>
 #include <astl/token.hpp>
+#include "buffer.hpp"
 #include "location.hpp"
 #include "parser.hpp"
 #include "scanner.hpp"
@@ -47,18 +48,18 @@ int main(int argc, char** argv) {
 
    SymTable symtab;
    Scanner* scanner;
-   std::ifstream* fin = 0;
+   SourceBuffer* source = nullptr;
    if (argc > 0) {
       char* fname = *argv++; --argc;
-      fin = new std::ifstream(fname);
       std::string filename(fname);
-      if (!*fin) {
-	 std::cerr << cmdname << ": unable to open " << fname <<
-	    " for reading" << std::endl;
+      try {
+	 source = new SourceBuffer(filename);
+      } catch (Exception& e) {
+	 std::cerr << cmdname << ": " << e.what() << std::endl;
 	 exit(1);
       }
-      if (locale) fin->imbue(*locale);
-      scanner = new Scanner(*fin, filename, symtab);
+      scanner = new Scanner(*source, filename, symtab,
+	 locale? *locale: std::locale());
    } else {
       if (locale) std::cin.imbue(*locale);
       scanner = new Scanner(std::cin, "stdin", symtab);
@@ -70,4 +71,5 @@ int main(int argc, char** argv) {
       std::cout << root << std::endl;
    }
    delete scanner;
+   if (source) delete source;
 }